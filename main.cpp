@@ -3,6 +3,19 @@
 #include <SDL2/SDL.h>
 #include <AquIce/SDL2/SDL.hpp>
 #include <AquIce/SDL3/SDL.hpp>
+#include <AquIce/SDL3/engine.hpp>
+#include <AquIce/SDL3/world.hpp>
+#include <AquIce/SDL3/mesh.hpp>
+#include <AquIce/SDL3/raster.hpp>
+#include <AquIce/SDL3/raycast.hpp>
+#include <AquIce/SDL3/pick.hpp>
+#include <AquIce/SDL3/stream.hpp>
+#include <AquIce/SDL3/region.hpp>
+#include <AquIce/SDL3/terrain.hpp>
+#include <AquIce/SDL3/queue.hpp>
+#include <AquIce/SDL3/frame.hpp>
+#include <AquIce/SDL3/light.hpp>
+#include <AquIce/SDL3/shadow.hpp>
 
 const int SCREEN_WIDTH = 1000;
 const int SCREEN_HEIGHT = 1000;
@@ -13,23 +26,62 @@ const int TEXTURE_HEIGHT = 2000;
 int main(int argc, char* argv[]) {
 	// Initialize SDL
 	auto config2 = AquIce_SDL2_Setup("Amber Engine", SCREEN_WIDTH, SCREEN_HEIGHT, 1);
-	auto config3 = SDL3_Config_new({200, 300}, 100, {-1, 1, 1});
-	
-	// Create an event
-	SDL_Event event;
+	SDL3_Engine engine = SDL3_Engine_new({200, 300}, 100, {-1, 1, 1});
+
+	// Create the world and its mesher
+	World* world = World_new();
+	ChunkMesher* mesher = ChunkMesher_new(engine.jobs, &engine.config);
 
 	// Create source and destination rectangles
 	SDL_Rect source = {0, 0, SCREEN_WIDTH / 32, SCREEN_HEIGHT / 32};
 	SDL_Rect dest = {10, 10, SCREEN_WIDTH - 20, SCREEN_HEIGHT - 20};
 
-	// Create a texture
+	// Stream an endless seeded terrain around the view, keeping the edited chunks in region files
+	RegionStore* store = RegionStore_new("world", engine.jobs);
+	RegionStore_load_palette(store, &world->palette);
+	ChunkStreamer* streamer = ChunkStreamer_new(engine.jobs, 64 << 20, 2, TerrainGenerator_chunk_generator(TerrainGenerator_new(1337), &world->palette), RegionStore_loader(store), RegionStore_saver(store, &world->palette));
+	ChunkStreamer_update(streamer, world, &engine.config, &source);
+
+	// Build a small scene above the terrain
+	Block brick, glass;
+	if(!Palette_block(&world->palette, {200, 80, 60, 255}, &brick) || !Palette_block(&world->palette, {60, 120, 220, 128}, &glass)) {
+		std::cerr << "The palette of the world is full" << std::endl;
+	}
+	World_set_block(world, 1, MAX_Y_COORD - 1, 1, brick);
+	World_set_block(world, 2, MAX_Y_COORD - 1, 2, glass);
+	
+	// Create the queue the input sends its edits and camera moves through, and the publisher of the frames drawn
+	EditQueue* edits = EditQueue_new();
+	WorldPublisher* publisher = WorldPublisher_new();
+	WorldLighting* lighting = WorldLighting_new(engine.jobs);
+	SunShadows* shadows = SunShadows_new();
+
+	// Record the edits from now on so they can be undone, spilling the oldest ones to disk
+	EditJournal* journal = EditJournal_new(EDIT_JOURNAL_BUDGET, "world.journal");
+	world->journal = journal;
+
+	// Create an event
+	SDL_Event event;
+
+	// Create a texture and the framebuffer drawn on it
 	SDL_Texture* texture = SDL_CreateTexture(
 		config2.renderer,
 		SDL_PIXELFORMAT_RGBA8888,
-		SDL_TEXTUREACCESS_TARGET,
+		SDL_TEXTUREACCESS_STREAMING,
 		TEXTURE_WIDTH,
 		TEXTURE_HEIGHT
 	);
+	Framebuffer fb = Framebuffer_new(TEXTURE_WIDTH, TEXTURE_HEIGHT);
+	DepthBuffer depth = DepthBuffer_new(TEXTURE_WIDTH, TEXTURE_HEIGHT);
+	PickBuffer pick = PickBuffer_new(TEXTURE_WIDTH, TEXTURE_HEIGHT);
+	bool raycast = false;
+	bool depth_test = false;
+	bool outlines = true;
+
+	// The block face under the mouse, from the picking buffer of the last frame, in the unbounded world
+	bool hovered = false;
+	coords3 hovered_pos;
+	Face hovered_face;
 
 	// Program loop
 	while(config2.running) {
@@ -61,28 +113,114 @@ int main(int argc, char* argv[]) {
 							source.w /= 2;
 							source.h /= 2;
 							break;
+						case SDLK_i:
+							EditQueue_move_camera(edits, {0, engine.config.ref_size});
+							break;
+						case SDLK_k:
+							EditQueue_move_camera(edits, {0, -engine.config.ref_size});
+							break;
+						case SDLK_j:
+							EditQueue_move_camera(edits, {engine.config.ref_size, 0});
+							break;
+						case SDLK_l:
+							EditQueue_move_camera(edits, {-engine.config.ref_size, 0});
+							break;
+						case SDLK_r:
+							// The raycaster draws no outlines, so they are turned off for both backends to show the same image
+							raycast = !raycast;
+							outlines = false;
+							break;
+						case SDLK_o:
+							outlines = !outlines;
+							break;
+						case SDLK_d:
+							depth_test = !depth_test;
+							break;
+						case SDLK_s:
+							RegionStore_save_world(store, world, streamer);
+							break;
+						case SDLK_z:
+							if(event.key.keysym.mod & KMOD_CTRL) {
+								EditQueue_undo(edits);
+							}
+							break;
+						case SDLK_y:
+							if(event.key.keysym.mod & KMOD_CTRL) {
+								EditQueue_redo(edits);
+							}
+							break;
+#ifdef AQUICE_DEBUG
+						case SDLK_p: {
+							// Print the job counters since the last time, in debug builds (-DAQUICE_DEBUG)
+							JobCounters counters = JobSystem_counters(engine.jobs, true);
+							std::cout << "Jobs: " << counters.executed << " run, " << counters.stolen << " stolen, " << counters.sleeps << " sleeps, " << counters.busy_ns / 1000000 << "ms busy" << std::endl;
+							break;
+						}
+#endif
 					}
 					break;
 				case SDL_MOUSEWHEEL: // Mouse Wheel
 					config2.scale += event.wheel.y > 0 ? 1 : -1;
+					break;
+				case SDL_MOUSEBUTTONDOWN: // Mouse Click
+					if(hovered) {
+						// Left click places a block on the face, right click removes the block
+						if(event.button.button == SDL_BUTTON_LEFT) {
+							coords3 normal = Face_normal(hovered_face);
+							EditQueue_set_block(edits, {hovered_pos.x + normal.x, hovered_pos.y + normal.y, hovered_pos.z + normal.z}, brick);
+						} else if(event.button.button == SDL_BUTTON_RIGHT) {
+							EditQueue_set_block(edits, hovered_pos, Block{});
+						}
+					}
+					break;
 			}
 		}
 
+		// Apply the edits sent since the last frame, stream the chunks around the view, relight and shadow them, publish the world, then mesh the dirty chunks and pick up the finished meshes
+		EditQueue_apply(edits, world, &engine.config);
+		ChunkStreamer_update(streamer, world, &engine.config, &source);
+		WorldLighting_update(lighting, world);
+		SunShadows_update(shadows, world, engine.config.sun_vec);
+		WorldPublisher_publish(publisher, world);
+		ChunkMesher_set_config(mesher, world, &engine.config);
+		ChunkMesher_dispatch(mesher, world, WorldPublisher_acquire(publisher));
+		ChunkMesher_adopt(mesher);
+
 		// Set render scale (zoom)
 		AquIce_SDL2_SetScale(&config2);
 
 		// Clear screen
 		AquIce_SDL2_ClearRenderer(config2.renderer);
 
-		// Clear the texture
-		SDL_SetRenderTarget(config2.renderer, texture);
-		SDL_SetRenderDrawColor(config2.renderer, 255, 255, 255, 255);
-		SDL_RenderClear(config2.renderer);
-
-		// Draw all the objects from the 3D config
+		// Clear the framebuffer and the picking buffer
+		Framebuffer_clear(&fb, {255, 255, 255, 255}, &source);
+		PickBuffer_clear(&pick, &source);
+
+		// Draw the world, from its meshes or by raycasting it
+		if(raycast) {
+			WorldFrameRef frame = WorldPublisher_acquire(publisher);
+			raycast_world(&fb, &frame->world, &engine.config, engine.jobs, &source, &pick);
+		} else {
+			int lod = ChunkMesh_select_lod((double)engine.config.ref_size * config2.scale * dest.w / source.w);
+			if(depth_test) {
+				raster_chunk_meshes_depth(&fb, &depth, &engine.config, mesher, engine.jobs, &source, lod, outlines, &pick);
+			} else {
+				raster_chunk_meshes_tiled(&fb, &engine.config, mesher, engine.jobs, &source, lod, outlines, &pick);
+			}
+		}
 
-		// Set back render target to window (nullptr -> default)
-		SDL_SetRenderTarget(config2.renderer, nullptr);
+		// Copy the framebuffer to the texture
+		Framebuffer_upload(&fb, texture, &source);
+
+		// Find the block face under the mouse
+		int mouse_x, mouse_y;
+		SDL_Point texture_point;
+		SDL_GetMouseState(&mouse_x, &mouse_y);
+		hovered = AquIce_SDL2_WindowToTexture(&config2, mouse_x, mouse_y, &source, &dest, &texture_point)
+			&& PickBuffer_get(&pick, texture_point.x, texture_point.y, &hovered_pos, &hovered_face);
+		if(hovered) {
+			hovered_pos = World_unbounded_pos(world, hovered_pos);
+		}
 
 		// Render texture
 		SDL_RenderClear(config2.renderer);
@@ -94,5 +232,17 @@ int main(int argc, char* argv[]) {
 		SDL_Delay(50);
 	}
 
+	EditQueue_free(edits);
+	world->journal = nullptr;
+	EditJournal_free(journal);
+	WorldPublisher_free(publisher);
+	WorldLighting_free(lighting);
+	SunShadows_free(shadows);
+	ChunkMesher_free(mesher);
+	ChunkStreamer_free(streamer);
+	RegionStore_free(store);
+	World_free(world);
+	SDL3_Engine_free(&engine);
+
 	return EXIT_SUCCESS;
 }
\ No newline at end of file
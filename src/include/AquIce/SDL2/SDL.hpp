@@ -68,6 +68,32 @@ void AquIce_SDL2_SetScale(AquIce_SDL2_Config* config) {
 	);
 }
 
+/**
+ * @brief Map a point of the window to the texture drawn on it
+ * @param config The configuration for the SDL2 library
+ * @param x The x coordinate in the window, in window pixels
+ * @param y The y coordinate in the window, in window pixels
+ * @param source The part of the texture drawn
+ * @param dest The part of the (scaled) renderer it is drawn on
+ * @param point The point of the texture to fill
+ * @return Whether the point of the window is on the texture (never with a scale of 0 or less)
+*/
+bool AquIce_SDL2_WindowToTexture(AquIce_SDL2_Config* config, int x, int y, SDL_Rect* source, SDL_Rect* dest, SDL_Point* point) {
+	// A window zoomed out to nothing shows no texture
+	if(config->scale <= 0) {
+		return false;
+	}
+	// Undo the render scale, then the stretching of the source rectangle over the destination one
+	double rx = (double)x / config->scale;
+	double ry = (double)y / config->scale;
+	if(rx < dest->x || ry < dest->y || rx >= dest->x + dest->w || ry >= dest->y + dest->h || source->w <= 0 || source->h <= 0) {
+		return false;
+	}
+	point->x = source->x + (int)((rx - dest->x) * source->w / dest->w);
+	point->y = source->y + (int)((ry - dest->y) * source->h / dest->h);
+	return true;
+}
+
 /**
  * @brief Clear the renderer
  * @param renderer The renderer to clear
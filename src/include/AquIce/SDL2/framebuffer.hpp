@@ -0,0 +1,599 @@
+#ifndef __AQUICE_SDL2_FRAMEBUFFER_HPP__
+#define __AQUICE_SDL2_FRAMEBUFFER_HPP__
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <immintrin.h>
+/**
+ * @brief Compile a function for AVX2 whatever the flags, it must only be called when SDL_HasAVX2
+*/
+#define FRAMEBUFFER_AVX2 __attribute__((target("avx2")))
+#endif
+
+#include "../../SDL2/SDL.h"
+#include "../utils/linegen.hpp"
+#include "../utils/ColorCodes.h"
+
+/**
+ * @brief A CPU framebuffer, in the SDL_PIXELFORMAT_RGBA8888 format
+*/
+typedef struct Framebuffer {
+	/**
+	 * @brief The width of the framebuffer
+	*/
+	int width;
+	/**
+	 * @brief The height of the framebuffer
+	*/
+	int height;
+	/**
+	 * @brief The pixels of the framebuffer, row by row
+	*/
+	std::vector<uint32_t> pixels;
+} Framebuffer;
+
+/**
+ * @brief A depth buffer, holding the depth of the nearest surface drawn on each pixel of a framebuffer
+ * @note A larger depth is nearer to the camera
+*/
+typedef struct DepthBuffer {
+	/**
+	 * @brief The width of the depth buffer
+	*/
+	int width;
+	/**
+	 * @brief The height of the depth buffer
+	*/
+	int height;
+	/**
+	 * @brief The depths of the pixels, row by row
+	*/
+	std::vector<float> values;
+} DepthBuffer;
+
+/**
+ * @brief Create a new framebuffer
+ * @param width The width of the framebuffer
+ * @param height The height of the framebuffer
+ * @return The framebuffer
+*/
+Framebuffer Framebuffer_new(int width, int height) {
+	return {
+		width,
+		height,
+		std::vector<uint32_t>(width * height, 0)
+	};
+}
+
+/**
+ * @brief Create a new depth buffer
+ * @param width The width of the depth buffer
+ * @param height The height of the depth buffer
+ * @return The depth buffer, with nothing drawn on it
+*/
+DepthBuffer DepthBuffer_new(int width, int height) {
+	return {
+		width,
+		height,
+		std::vector<float>(width * height, -INFINITY)
+	};
+}
+
+/**
+ * @brief Pack an RGBA color in the format of the framebuffer
+ * @param rgba The RGBA color
+ * @return The packed color
+*/
+uint32_t RGBA_pack(RGBA rgba) {
+	return (uint32_t)rgba.r << 24 | (uint32_t)rgba.g << 16 | (uint32_t)rgba.b << 8 | (uint32_t)rgba.a;
+}
+
+/**
+ * @brief Blend a color over a packed color
+ * @param dst The packed color below
+ * @param rgba The RGBA color to blend over it
+ * @return The packed blended color
+*/
+uint32_t RGBA_blend(uint32_t dst, RGBA rgba) {
+	int a = rgba.a;
+	int r = (rgba.r * a + (int)(dst >> 24 & 0xFF) * (255 - a)) / 255;
+	int g = (rgba.g * a + (int)(dst >> 16 & 0xFF) * (255 - a)) / 255;
+	int b = (rgba.b * a + (int)(dst >> 8 & 0xFF) * (255 - a)) / 255;
+	return RGBA_pack({r, g, b, 255});
+}
+
+#ifdef __SSE2__
+/**
+ * @brief Blend a color over 4 packed colors, exactly like RGBA_blend
+ * @param dst The 4 packed colors below
+ * @param src The channels of the color times its alpha, for two pixels on 16 bits each
+ * @param inverse 255 minus the alpha of the color, on every 16 bits
+*/
+__m128i RGBA_blend4(__m128i dst, __m128i src, __m128i inverse) {
+	__m128i zero = _mm_setzero_si128();
+	__m128i low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), inverse), src);
+	__m128i high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), inverse), src);
+	// x / 255 is (x + 1 + (x >> 8)) >> 8 for any x up to 255 * 255
+	__m128i one = _mm_set1_epi16(1);
+	low = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(low, one), _mm_srli_epi16(low, 8)), 8);
+	high = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(high, one), _mm_srli_epi16(high, 8)), 8);
+	return _mm_or_si128(_mm_packus_epi16(low, high), _mm_set1_epi32(0xFF));
+}
+#endif
+
+#ifdef FRAMEBUFFER_AVX2
+/**
+ * @brief Blend a color over 8 packed colors, exactly like RGBA_blend
+ * @param dst The 8 packed colors below
+ * @param src The channels of the color times its alpha, for two pixels on 16 bits each in both halves
+ * @param inverse 255 minus the alpha of the color, on every 16 bits
+*/
+FRAMEBUFFER_AVX2 __m256i RGBA_blend8(__m256i dst, __m256i src, __m256i inverse) {
+	__m256i zero = _mm256_setzero_si256();
+	__m256i low = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(dst, zero), inverse), src);
+	__m256i high = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(dst, zero), inverse), src);
+	__m256i one = _mm256_set1_epi16(1);
+	low = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(low, one), _mm256_srli_epi16(low, 8)), 8);
+	high = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(high, one), _mm256_srli_epi16(high, 8)), 8);
+	return _mm256_or_si256(_mm256_packus_epi16(low, high), _mm256_set1_epi32(0xFF));
+}
+
+/**
+ * @brief Blend a color over the pixels of a span 8 at a time
+ * @param pixels The first packed color of the span
+ * @param count The number of packed colors of the span
+ * @param rgba The RGBA color to blend over them
+ * @return The number of pixels blended, a multiple of 8
+*/
+FRAMEBUFFER_AVX2 int RGBA_blend_span8(uint32_t* pixels, int count, RGBA rgba) {
+	int a = rgba.a;
+	short b = (short)(rgba.b * a), g = (short)(rgba.g * a), r = (short)(rgba.r * a);
+	__m256i src8 = _mm256_setr_epi16(0, b, g, r, 0, b, g, r, 0, b, g, r, 0, b, g, r);
+	__m256i inverse8 = _mm256_set1_epi16((short)(255 - a));
+	int i = 0;
+	for(; i + 8 <= count; i += 8) {
+		__m256i dst = _mm256_loadu_si256((const __m256i*)(pixels + i));
+		_mm256_storeu_si256((__m256i*)(pixels + i), RGBA_blend8(dst, src8, inverse8));
+	}
+	return i;
+}
+#endif
+
+/**
+ * @brief Blend a color over a span of packed colors
+ * @param pixels The first packed color of the span
+ * @param count The number of packed colors of the span
+ * @param rgba The RGBA color to blend over them
+ * @note Blends 8 pixels at once when the CPU has AVX2, else 4 with SSE2, the rest one by one, with the same result as RGBA_blend
+*/
+void RGBA_blend_span(uint32_t* pixels, int count, RGBA rgba) {
+	int i = 0;
+#ifdef FRAMEBUFFER_AVX2
+	static const bool avx2 = SDL_HasAVX2();
+	if(avx2) {
+		i = RGBA_blend_span8(pixels, count, rgba);
+	}
+#endif
+#ifdef __SSE2__
+	// The channels of a packed color from its lowest byte up: alpha (forced to 255 after), blue, green, red
+	int a = rgba.a;
+	short b = (short)(rgba.b * a), g = (short)(rgba.g * a), r = (short)(rgba.r * a);
+	__m128i src4 = _mm_setr_epi16(0, b, g, r, 0, b, g, r);
+	__m128i inverse4 = _mm_set1_epi16((short)(255 - a));
+	for(; i + 4 <= count; i += 4) {
+		__m128i dst = _mm_loadu_si128((const __m128i*)(pixels + i));
+		_mm_storeu_si128((__m128i*)(pixels + i), RGBA_blend4(dst, src4, inverse4));
+	}
+#endif
+	for(; i < count; i++) {
+		pixels[i] = RGBA_blend(pixels[i], rgba);
+	}
+}
+
+/**
+ * @brief Scale the color channels of a color
+ * @param rgba The RGBA color
+ * @param factor The factor, out of 255
+ * @return The scaled color, its alpha unchanged
+*/
+RGBA RGBA_scale(RGBA rgba, int factor) {
+	return {rgba.r * factor / 255, rgba.g * factor / 255, rgba.b * factor / 255, rgba.a};
+}
+
+/**
+ * @brief Clip a rectangle to a framebuffer
+ * @param fb The framebuffer
+ * @param rect The rectangle (nullptr for the whole framebuffer)
+ * @return The part of the rectangle inside the framebuffer
+*/
+SDL_Rect Framebuffer_clip(Framebuffer* fb, SDL_Rect* rect) {
+	if(!rect) {
+		return {0, 0, fb->width, fb->height};
+	}
+	int x0 = std::max(rect->x, 0);
+	int y0 = std::max(rect->y, 0);
+	int x1 = std::min(rect->x + rect->w, fb->width);
+	int y1 = std::min(rect->y + rect->h, fb->height);
+	return {x0, y0, std::max(x1 - x0, 0), std::max(y1 - y0, 0)};
+}
+
+/**
+ * @brief Clear a framebuffer
+ * @param fb The framebuffer
+ * @param rgba The RGBA color to clear with
+ * @param rect The part of the framebuffer to clear (nullptr for all of it)
+*/
+void Framebuffer_clear(Framebuffer* fb, RGBA rgba, SDL_Rect* rect = nullptr) {
+	SDL_Rect clip = Framebuffer_clip(fb, rect);
+	uint32_t color = RGBA_pack(rgba);
+	for(int y = clip.y; y < clip.y + clip.h; y++) {
+		std::fill_n(fb->pixels.begin() + y * fb->width + clip.x, clip.w, color);
+	}
+}
+
+/**
+ * @brief Clear a depth buffer so nothing is drawn on it
+ * @param depth The depth buffer
+ * @param rect The part of the depth buffer to clear (nullptr for all of it)
+*/
+void DepthBuffer_clear(DepthBuffer* depth, SDL_Rect* rect = nullptr) {
+	int x0 = rect ? std::max(rect->x, 0) : 0;
+	int y0 = rect ? std::max(rect->y, 0) : 0;
+	int x1 = rect ? std::min(rect->x + rect->w, depth->width) : depth->width;
+	int y1 = rect ? std::min(rect->y + rect->h, depth->height) : depth->height;
+	for(int y = y0; y < y1; y++) {
+		std::fill(depth->values.begin() + y * depth->width + x0, depth->values.begin() + y * depth->width + std::max(x1, x0), -INFINITY);
+	}
+}
+
+/**
+ * @brief Draw a pixel on a framebuffer
+ * @param fb The framebuffer
+ * @param x The x coordinate of the pixel
+ * @param y The y coordinate of the pixel
+ * @param rgba The RGBA color, blended if it is see-through
+*/
+void Framebuffer_draw_pixel(Framebuffer* fb, int x, int y, RGBA rgba) {
+	uint32_t& pixel = fb->pixels[y * fb->width + x];
+	pixel = rgba.a == 255 ? RGBA_pack(rgba) : RGBA_blend(pixel, rgba);
+}
+
+/**
+ * @brief Draw a line on a framebuffer
+ * @param fb The framebuffer
+ * @param from The starting point
+ * @param to The ending point
+ * @param rgba The RGBA color
+ * @param clip The part of the framebuffer to draw in
+*/
+void Framebuffer_draw_line(Framebuffer* fb, coords from, coords to, RGBA rgba, SDL_Rect clip) {
+	for(auto p : linegen(from, to).line_vec) {
+		if(p.x >= clip.x && p.y >= clip.y && p.x < clip.x + clip.w && p.y < clip.y + clip.h) {
+			Framebuffer_draw_pixel(fb, p.x, p.y, rgba);
+		}
+	}
+}
+
+/**
+ * @brief Visit the rows of pixels covered by a convex quad
+ * @param corners The corners of the quad, in loop order
+ * @param clip The part of the screen to visit
+ * @param span The function called for each row, from top to bottom, with its y coordinate and the x coordinates of its first covered pixel and past its last one
+ * @note A pixel is covered when its center is inside the quad, with the top-left rule on the edges,
+ * @note so quads sharing an edge never cover the same pixel twice
+ * @note The covered pixels of a row of a convex quad are contiguous, found from the edge functions without visiting them
+*/
+template<typename Span>
+void scan_quad_spans(std::array<coords, 4> corners, SDL_Rect clip, Span span) {
+	// Work with doubled coordinates so the pixel centers are integers
+	int64_t area = 0;
+	for(int i = 0; i < 4; i++) {
+		area += (int64_t)corners[i].x * corners[(i + 1) % 4].y - (int64_t)corners[(i + 1) % 4].x * corners[i].y;
+	}
+	if(area == 0) {
+		return;
+	}
+	if(area < 0) {
+		std::swap(corners[1], corners[3]);
+	}
+
+	int x0 = clip.x, y0 = clip.y, x1 = clip.x + clip.w, y1 = clip.y + clip.h;
+	int min_x = corners[0].x, max_x = corners[0].x, min_y = corners[0].y, max_y = corners[0].y;
+	for(auto& corner : corners) {
+		min_x = std::min(min_x, corner.x);
+		max_x = std::max(max_x, corner.x);
+		min_y = std::min(min_y, corner.y);
+		max_y = std::max(max_y, corner.y);
+	}
+	x0 = std::max(x0, min_x);
+	y0 = std::max(y0, min_y);
+	x1 = std::min(x1, max_x);
+	y1 = std::min(y1, max_y);
+	if(x0 >= x1 || y0 >= y1) {
+		return;
+	}
+
+	// Edge function of each edge at the center of the first pixel, and its steps along x and y
+	std::array<int64_t, 4> row, step_x, step_y;
+	for(int i = 0; i < 4; i++) {
+		coords a = corners[i];
+		coords b = corners[(i + 1) % 4];
+		int64_t dx = b.x - a.x;
+		int64_t dy = b.y - a.y;
+		row[i] = dx * (2 * y0 + 1 - 2 * a.y) - dy * (2 * x0 + 1 - 2 * a.x);
+		step_x[i] = -2 * dy;
+		step_y[i] = 2 * dx;
+		// Pixels exactly on an edge which is neither a top nor a left one are outside
+		bool top_left = (dy == 0 && dx > 0) || dy < 0;
+		if(!top_left) {
+			row[i]--;
+		}
+	}
+
+	for(int y = y0; y < y1; y++) {
+		// The pixels x0 + k where every edge function row + step_x * k is positive
+		int64_t begin = 0, end = x1 - x0;
+		for(int i = 0; i < 4 && begin < end; i++) {
+			int64_t e = row[i], step = step_x[i];
+			if(step > 0) {
+				// k >= ceil(-e / step)
+				int64_t first = e >= 0 ? -(e / step) : (-e + step - 1) / step;
+				begin = std::max(begin, first);
+			} else if(step < 0) {
+				// k <= floor(e / -step)
+				int64_t last = e >= 0 ? e / -step : -((-e - step - 1) / -step);
+				end = std::min(end, last + 1);
+			} else if(e < 0) {
+				end = begin;
+			}
+		}
+		if(begin < end) {
+			span(y, x0 + (int)begin, x0 + (int)end);
+		}
+		for(int i = 0; i < 4; i++) {
+			row[i] += step_y[i];
+		}
+	}
+}
+
+/**
+ * @brief Visit the pixels covered by a convex quad
+ * @param corners The corners of the quad, in loop order
+ * @param clip The part of the screen to visit
+ * @param plot The function called with the coordinates of each covered pixel, row by row
+ * @note The pixels covered are the ones of scan_quad_spans
+*/
+template<typename Plot>
+void scan_quad(std::array<coords, 4> corners, SDL_Rect clip, Plot plot) {
+	scan_quad_spans(corners, clip, [&](int y, int begin, int end) {
+		for(int x = begin; x < end; x++) {
+			plot(x, y);
+		}
+	});
+}
+
+/**
+ * @brief Fill a convex quad on a framebuffer
+ * @param fb The framebuffer
+ * @param corners The corners of the quad, in loop order
+ * @param rgba The RGBA color, blended if it is see-through
+ * @param clip The part of the framebuffer to draw in
+ * @note The pixels filled are the ones covered by scan_quad, a row at a time: opaque rows are plain fills,
+ * @note see-through ones are blended with RGBA_blend_span
+*/
+void Framebuffer_fill_quad(Framebuffer* fb, std::array<coords, 4> corners, RGBA rgba, SDL_Rect clip) {
+	uint32_t color = RGBA_pack(rgba);
+	uint32_t* pixels = fb->pixels.data();
+	int width = fb->width;
+	scan_quad_spans(corners, clip, [&](int y, int begin, int end) {
+		if(rgba.a == 255) {
+			std::fill(pixels + y * width + begin, pixels + y * width + end, color);
+		} else {
+			RGBA_blend_span(pixels + y * width + begin, end - begin, rgba);
+		}
+	});
+}
+
+/**
+ * @brief The coordinates of the pixels over a quad along two of its edges, affine functions of the pixel coordinates
+ * @note The quad is taken as the parallelogram of its first corner and the edges to its second and fourth corners
+*/
+typedef struct QuadCoords {
+	/**
+	 * @brief The coordinate along the edge to the second corner at the center of the pixel (0, 0), and its steps along x and y
+	*/
+	double u, u_dx, u_dy;
+	/**
+	 * @brief The coordinate along the edge to the fourth corner at the center of the pixel (0, 0), and its steps along x and y
+	*/
+	double v, v_dx, v_dy;
+} QuadCoords;
+
+/**
+ * @brief Get the coordinates of the pixels over a quad
+ * @param corners The corners of the quad, in loop order
+ * @return The coordinates, 0 at the first corner and 1 at the second (u) or fourth (v) one
+*/
+QuadCoords QuadCoords_new(const std::array<coords, 4>& corners) {
+	double e1x = corners[1].x - corners[0].x, e1y = corners[1].y - corners[0].y;
+	double e2x = corners[3].x - corners[0].x, e2y = corners[3].y - corners[0].y;
+	double det = e1x * e2y - e1y * e2x;
+	if(det == 0) {
+		return {0, 0, 0, 0, 0, 0};
+	}
+	double px = 0.5 - corners[0].x, py = 0.5 - corners[0].y;
+	return {
+		(px * e2y - py * e2x) / det, e2y / det, -e2x / det,
+		(py * e1x - px * e1y) / det, -e1y / det, e1x / det
+	};
+}
+
+/**
+ * @brief Interpolate values given at the corners of a quad
+ * @param values The values at the corners, in loop order
+ * @param u The coordinate along the edge to the second corner (clamped to 0 to 1)
+ * @param v The coordinate along the edge to the fourth corner (clamped to 0 to 1)
+ * @return The value, interpolated bilinearly and rounded
+*/
+int Quad_bilinear(const std::array<uint8_t, 4>& values, double u, double v) {
+	u = std::min(std::max(u, 0.0), 1.0);
+	v = std::min(std::max(v, 0.0), 1.0);
+	double value = (1 - u) * (1 - v) * values[0] + u * (1 - v) * values[1] + u * v * values[2] + (1 - u) * v * values[3];
+	return (int)(value + 0.5);
+}
+
+/**
+ * @brief The number of fractional bits of the coordinates over a quad stepped along a row of pixels
+*/
+#define QUAD_ROW_BITS 24
+
+/**
+ * @brief The coordinates over a quad along a row of pixels, in fixed point, stepped one pixel at a time
+*/
+typedef struct QuadRow {
+	/**
+	 * @brief The coordinates at the current pixel
+	*/
+	int64_t u, v;
+	/**
+	 * @brief The steps of the coordinates to the next pixel
+	*/
+	int64_t u_dx, v_dx;
+} QuadRow;
+
+/**
+ * @brief Start stepping the coordinates over a quad along a row of pixels
+ * @param uv The coordinates over the quad
+ * @param x The x coordinate of the first pixel
+ * @param y The y coordinate of the row
+ * @return The coordinates of the row, at the first pixel
+*/
+QuadRow QuadRow_new(const QuadCoords& uv, int x, int y) {
+	double one = (double)((int64_t)1 << QUAD_ROW_BITS);
+	return {
+		std::llround((uv.u + uv.u_dx * x + uv.u_dy * y) * one),
+		std::llround((uv.v + uv.v_dx * x + uv.v_dy * y) * one),
+		std::llround(uv.u_dx * one),
+		std::llround(uv.v_dx * one)
+	};
+}
+
+/**
+ * @brief Interpolate values given at the corners of a quad at the current pixel of a row, then step to the next pixel
+ * @param row The coordinates of the row
+ * @param values The values at the corners, in loop order
+ * @return The value, interpolated bilinearly and rounded like Quad_bilinear, with integers only
+*/
+int QuadRow_next(QuadRow* row, const std::array<uint8_t, 4>& values) {
+	const int64_t one = (int64_t)1 << QUAD_ROW_BITS;
+	int64_t u = std::min(std::max(row->u, (int64_t)0), one);
+	int64_t v = std::min(std::max(row->v, (int64_t)0), one);
+	row->u += row->u_dx;
+	row->v += row->v_dx;
+	int64_t top = values[0] * (one - u) + values[1] * u;
+	int64_t bottom = values[3] * (one - u) + values[2] * u;
+	return (int)((top * (one - v) + bottom * v + ((int64_t)1 << (2 * QUAD_ROW_BITS - 1))) >> (2 * QUAD_ROW_BITS));
+}
+
+/**
+ * @brief Interpolate values given at the corners of a quad along a span of a row of pixels
+ * @param row The coordinates of the row at the first pixel of the span
+ * @param values The values at the corners, in loop order
+ * @param count The number of pixels of the span
+ * @param plot The function called with the index of each pixel in the span and its value, in order
+ * @note When the span stays inside the quad, the value is a quadratic of the pixel stepped with two additions per pixel,
+ * @note else each pixel is interpolated with QuadRow_next, both giving the same values
+*/
+template<typename Plot>
+void QuadRow_span(QuadRow row, const std::array<uint8_t, 4>& values, int count, Plot plot) {
+	const int64_t one = (int64_t)1 << QUAD_ROW_BITS;
+	int64_t u_last = row.u + row.u_dx * (count - 1);
+	int64_t v_last = row.v + row.v_dx * (count - 1);
+	bool inside = row.u >= 0 && row.u <= one && u_last >= 0 && u_last <= one
+		&& row.v >= 0 && row.v <= one && v_last >= 0 && v_last <= one;
+	if(!inside) {
+		for(int i = 0; i < count; i++) {
+			plot(i, QuadRow_next(&row, values));
+		}
+		return;
+	}
+	// value * one^2 = c0 one^2 + cu one u + cv one v + cuv u v, with u and v affine in the pixel
+	int64_t c0 = values[0], cu = values[1] - values[0], cv = values[3] - values[0];
+	int64_t cuv = values[2] - values[3] - values[1] + values[0];
+	int64_t value = c0 * one * one + cu * one * row.u + cv * one * row.v + cuv * row.u * row.v;
+	// Its first and second differences from one pixel to the next
+	int64_t curve = cuv * row.u_dx * row.v_dx;
+	int64_t step = cu * one * row.u_dx + cv * one * row.v_dx + cuv * (row.u * row.v_dx + row.v * row.u_dx) + curve;
+	const int64_t half = (int64_t)1 << (2 * QUAD_ROW_BITS - 1);
+	for(int i = 0; i < count; i++) {
+		plot(i, (int)((value + half) >> (2 * QUAD_ROW_BITS)));
+		value += step;
+		step += 2 * curve;
+	}
+}
+
+/**
+ * @brief Fill a convex quad on a framebuffer with a color shaded differently at each corner
+ * @param fb The framebuffer
+ * @param corners The corners of the quad, in loop order
+ * @param rgba The RGBA color, blended if it is see-through
+ * @param shades The brightness at each corner, out of 255, interpolated bilinearly over the quad
+ * @param clip The part of the framebuffer to draw in
+ * @note The pixels filled are the ones covered by scan_quad_spans, the brightness being stepped along each span with QuadRow_span
+*/
+void Framebuffer_fill_quad_shaded(Framebuffer* fb, std::array<coords, 4> corners, RGBA rgba, const std::array<uint8_t, 4>& shades, SDL_Rect clip) {
+	QuadCoords uv = QuadCoords_new(corners);
+	uint32_t* pixels = fb->pixels.data();
+	int width = fb->width;
+	scan_quad_spans(corners, clip, [&](int y, int begin, int end) {
+		uint32_t* span = pixels + y * width + begin;
+		QuadRow_span(QuadRow_new(uv, begin, y), shades, end - begin, [&](int i, int shade) {
+			RGBA shaded = RGBA_scale(rgba, shade);
+			span[i] = rgba.a == 255 ? RGBA_pack(shaded) : RGBA_blend(span[i], shaded);
+		});
+	});
+}
+
+/**
+ * @brief Fill a convex quad on a framebuffer with an opaque color at a brightness interpolated between its corners
+ * @param fb The framebuffer
+ * @param corners The corners of the quad, in loop order
+ * @param ramp The packed color at every brightness, out of 255
+ * @param shades The brightness at each corner, interpolated bilinearly over the quad
+ * @param clip The part of the framebuffer to draw in
+ * @note The pixels are looked up in the ramp, so no color is computed per pixel, and the brightness is stepped along each span with QuadRow_span
+*/
+void Framebuffer_fill_quad_ramp(Framebuffer* fb, std::array<coords, 4> corners, const uint32_t* ramp, const std::array<uint8_t, 4>& shades, SDL_Rect clip) {
+	QuadCoords uv = QuadCoords_new(corners);
+	uint32_t* pixels = fb->pixels.data();
+	int width = fb->width;
+	scan_quad_spans(corners, clip, [&](int y, int begin, int end) {
+		uint32_t* span = pixels + y * width + begin;
+		QuadRow_span(QuadRow_new(uv, begin, y), shades, end - begin, [&](int i, int shade) {
+			span[i] = ramp[shade];
+		});
+	});
+}
+
+/**
+ * @brief Copy a framebuffer to a texture
+ * @param fb The framebuffer
+ * @param texture The texture, of the same size and in the SDL_PIXELFORMAT_RGBA8888 format
+ * @param rect The part of the framebuffer to copy (nullptr for all of it)
+*/
+void Framebuffer_upload(Framebuffer* fb, SDL_Texture* texture, SDL_Rect* rect = nullptr) {
+	SDL_Rect clip = Framebuffer_clip(fb, rect);
+	if(clip.w > 0 && clip.h > 0) {
+		SDL_UpdateTexture(texture, &clip, &fb->pixels[clip.y * fb->width + clip.x], fb->width * sizeof(uint32_t));
+	}
+}
+
+#endif
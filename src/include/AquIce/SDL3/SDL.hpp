@@ -13,6 +13,10 @@
  * @brief The constant PI
 */
 #define PI 3.14159265358979323846
+/**
+ * @brief The angle for the perspective
+*/
+#define P_ANGLE 30
 
 /**
  * @brief A struct to represent a 3D point
@@ -32,6 +36,24 @@ typedef struct coords3 {
 	int z;
 } coords3;
 
+/**
+ * @brief A struct to represent a 3D point with real coordinates
+*/
+typedef struct vec3 {
+	/**
+	 * @brief The x coordinate
+	*/
+	double x;
+	/**
+	 * @brief The y coordinate
+	*/
+	double y;
+	/**
+	 * @brief The z coordinate
+	*/
+	double z;
+} vec3;
+
 /**
  * @brief A struct to represent a 3D mesh point
 */
@@ -76,12 +98,34 @@ typedef struct SDL3_Config {
 	 * @brief The vector of the camera
 	*/
 	coords3 cam_vec;
+	/**
+	 * @brief The vector pointing towards the sun, only the signs of its components counting like for the camera
+	*/
+	coords3 sun_vec;
 	/**
 	 * @brief The origin of the SDL3 configuration
 	*/
 	coords origin;
 } SDL3_Config;
 
+/**
+ * @brief The 2D sizes of the sides of a cube
+*/
+typedef struct SDL3_Sizes {
+	/**
+	 * @brief The horizontal size of a side along the x and z axes
+	*/
+	int adjsize;
+	/**
+	 * @brief The vertical size of a side along the x and z axes
+	*/
+	int oppsize;
+	/**
+	 * @brief The vertical size of a side along the y axis
+	*/
+	int hypsize;
+} SDL3_Sizes;
+
 /**
  * @brief Convert degrees to radians
  * @param degangle The angle in degrees
@@ -104,12 +148,14 @@ double dtrig(double (*trig_fn)(double), double radangle) {
 /**
  * @brief Create a new SDL3 configuration
  * @param size The size of the cube
+ * @param sun_vec The vector pointing towards the sun
  * @return The SDL3 configuration
 */
-SDL3_Config SDL3_Config_new(coords origin, int size, coords3 cam_vec) {
+SDL3_Config SDL3_Config_new(coords origin, int size, coords3 cam_vec, coords3 sun_vec = {-1, 1, -1}) {
 	return  SDL3_Config{
 		size,
 		cam_vec,
+		sun_vec,
 		origin
 	};
 }
@@ -150,6 +196,62 @@ MeshLine MeshLine_new(MeshPoint* start, MeshPoint* end) {
 	return {start, end};
 }
 
+/**
+ * @brief Get the 2D sizes of the sides of a cube
+ * @param config The SDL3 configuration
+ * @return The 2D sizes
+ * @note The vertical sizes are kept in a 1:2 ratio so the points along the camera vector overlap exactly
+*/
+SDL3_Sizes SDL3_Config_sizes(SDL3_Config* config) {
+	int oppsize = config->ref_size / 2;
+	return {
+		iround(config->ref_size * dtrig(sin, 90 - P_ANGLE)),
+		oppsize,
+		2 * oppsize
+	};
+}
+
+/**
+ * @brief Get the offset of the 2D coordinates of a 3D point from the origin
+ * @param p The 3D point
+ * @param config The SDL3 configuration
+ * @return The 2D offset of the 3D point
+ * @note The y axis is the vertical one, and every point on a line parallel to the camera vector has the same offset
+*/
+coords get_2d_offset(coords3 p, SDL3_Config* config) {
+	SDL3_Sizes sizes = SDL3_Config_sizes(config);
+	int sx = config->cam_vec.x < 0 ? -1 : 1;
+	int sy = config->cam_vec.y < 0 ? -1 : 1;
+	int sz = config->cam_vec.z < 0 ? -1 : 1;
+
+	return {
+		sizes.adjsize * (sz * p.x - sx * p.z),
+		sizes.oppsize * (sx * p.x + sz * p.z) - sizes.hypsize * sy * p.y
+	};
+}
+
+/**
+ * @brief Get the 3D point at height 0 with a given 2D offset from the origin
+ * @param x The x offset from the origin
+ * @param y The y offset from the origin
+ * @param config The SDL3 configuration
+ * @return The 3D point, every point projected at the same offset being on the line through it parallel to the camera vector
+ * @note This is the inverse of get_2d_offset, with real coordinates
+*/
+vec3 get_3d_point(double x, double y, SDL3_Config* config) {
+	SDL3_Sizes sizes = SDL3_Config_sizes(config);
+	int sx = config->cam_vec.x < 0 ? -1 : 1;
+	int sz = config->cam_vec.z < 0 ? -1 : 1;
+	double u = x / sizes.adjsize;
+	double v = y / sizes.oppsize;
+
+	return {
+		(sz * u + sx * v) / 2,
+		0,
+		(sz * v - sx * u) / 2
+	};
+}
+
 /**
  * @brief Get the 2D coordinates of a 3D point
  * @param p The 3D point
@@ -157,16 +259,37 @@ MeshLine MeshLine_new(MeshPoint* start, MeshPoint* end) {
  * @return The 2D coordinates of the 3D point
 */
 coords get_2d_coords(coords3 p, SDL3_Config* config) {
+	coords offset = get_2d_offset(p, config);
 	coords p2 = {
-		config->origin.x,
-		config->origin.y
+		config->origin.x + offset.x,
+		config->origin.y + offset.y
 	};
-	
-	// Make modifications to p2 to get the 2D coordinates of p
 
 	return p2;
 }
 
+/**
+ * @brief Get the 2D bounding box of a 3D box
+ * @param min The minimum corner of the box
+ * @param max The maximum corner of the box
+ * @param config The SDL3 configuration
+ * @return The smallest rectangle containing the 2D coordinates of the 8 corners of the box
+*/
+SDL_Rect get_2d_bounds(coords3 min, coords3 max, SDL3_Config* config) {
+	coords low = get_2d_coords(min, config);
+	coords high = low;
+	for(int corner = 1; corner < 8; corner++) {
+		coords p = get_2d_coords({
+			corner & 1 ? max.x : min.x,
+			corner & 2 ? max.y : min.y,
+			corner & 4 ? max.z : min.z
+		}, config);
+		low = {std::min(low.x, p.x), std::min(low.y, p.y)};
+		high = {std::max(high.x, p.x), std::max(high.y, p.y)};
+	}
+	return {low.x, low.y, high.x - low.x + 1, high.y - low.y + 1};
+}
+
 /**
  * @brief Draw a mesh line
  * @param renderer The SDL renderer
@@ -0,0 +1,135 @@
+#ifndef __AQUICE_SDL3_AO_HPP__
+#define __AQUICE_SDL3_AO_HPP__
+
+#include <array>
+#include <cstdint>
+
+#include "SDL.hpp"
+#include "world.hpp"
+
+/**
+ * @brief The ambient occlusion of a face corner with no opaque block around it, the highest one
+*/
+#define AO_MAX 3
+
+/**
+ * @brief The brightness of a face corner for each ambient occlusion, out of 255
+*/
+const std::array<uint8_t, AO_MAX + 1> AO_SHADES = {150, 185, 220, 255};
+
+/**
+ * @brief The opacity of the blocks of a chunk and of the blocks of its neighbors around it, one block thick
+ * @note Indexed by z + 1 then y + 1, the bit of a block in its row being x + 1
+*/
+typedef std::array<std::array<uint16_t, Y_CHUNK_SIZE + 2>, Z_CHUNK_SIZE + 2> ChunkApron;
+
+/**
+ * @brief Check whether a block of a chunk apron is opaque
+ * @param apron The chunk apron
+ * @param x The x coordinate of the block in the chunk (-1 to X_CHUNK_SIZE)
+ * @param y The y coordinate of the block in the chunk (-1 to Y_CHUNK_SIZE)
+ * @param z The z coordinate of the block in the chunk (-1 to Z_CHUNK_SIZE)
+ * @return Whether the block is opaque
+*/
+bool ChunkApron_opaque(const ChunkApron& apron, int x, int y, int z) {
+	return apron[z + 1][y + 1] >> (x + 1) & 1;
+}
+
+/**
+ * @brief Get the apron of a chunk of a world
+ * @param world The world
+ * @param cx The x coordinate of the chunk
+ * @param cy The y coordinate of the chunk
+ * @param cz The z coordinate of the chunk
+ * @return The apron of the chunk, the blocks outside the world being transparent
+ * @note Reads the 26 neighbors of the chunk, the diagonal ones included
+*/
+ChunkApron World_chunk_apron(World* world, int cx, int cy, int cz) {
+	ChunkApron apron;
+	for(int z = -1; z <= Z_CHUNK_SIZE; z++) {
+		int dz = z < 0 ? -1 : (z == Z_CHUNK_SIZE ? 1 : 0);
+		int lz = z - dz * Z_CHUNK_SIZE;
+		for(int y = -1; y <= Y_CHUNK_SIZE; y++) {
+			int dy = y < 0 ? -1 : (y == Y_CHUNK_SIZE ? 1 : 0);
+			int ly = y - dy * Y_CHUNK_SIZE;
+			const Chunk* before = World_get_chunk(world, cx - 1, cy + dy, cz + dz);
+			const Chunk* chunk = World_get_chunk(world, cx, cy + dy, cz + dz);
+			const Chunk* after = World_get_chunk(world, cx + 1, cy + dy, cz + dz);
+			uint16_t row = 0;
+			if(before) {
+				row |= before->opacity[lz] >> (ly * X_CHUNK_SIZE + X_CHUNK_SIZE - 1) & 1;
+			}
+			if(chunk) {
+				row |= (uint16_t)(chunk->opacity[lz] >> (ly * X_CHUNK_SIZE) & 0xFF) << 1;
+			}
+			if(after) {
+				row |= (uint16_t)(after->opacity[lz] >> (ly * X_CHUNK_SIZE) & 1) << (X_CHUNK_SIZE + 1);
+			}
+			apron[z + 1][y + 1] = row;
+		}
+	}
+	return apron;
+}
+
+/**
+ * @brief Compute the ambient occlusion of the corners of a face of a block
+ * @param pos The position of the block
+ * @param face The face
+ * @param opaque The function telling whether the block of a position is opaque
+ * @return The ambient occlusion of the corners of the face (0 to AO_MAX), in the order of Face_corners
+ * @note Each corner looks at the 3 blocks around it in front of the face: the two sides and the diagonal,
+ * @note a corner between two opaque sides being fully occluded whatever the diagonal
+*/
+template<typename Opaque>
+std::array<uint8_t, 4> Face_ao(coords3 pos, Face face, Opaque opaque) {
+	coords3 normal = Face_normal(face);
+	std::array<int, 3> front = {pos.x + normal.x, pos.y + normal.y, pos.z + normal.z};
+	// The tangent axes of the face, in the order its corners go along them
+	int axis = face / 2;
+	int u = axis == 0 ? 1 : 0;
+	int v = axis == 2 ? 1 : 2;
+	const int corner_u[4] = {-1, 1, 1, -1};
+	const int corner_v[4] = {-1, -1, 1, 1};
+
+	std::array<uint8_t, 4> ao;
+	for(int i = 0; i < 4; i++) {
+		std::array<int, 3> side_u = front, side_v = front, diagonal = front;
+		side_u[u] += corner_u[i];
+		side_v[v] += corner_v[i];
+		diagonal[u] += corner_u[i];
+		diagonal[v] += corner_v[i];
+		bool a = opaque(side_u[0], side_u[1], side_u[2]);
+		bool b = opaque(side_v[0], side_v[1], side_v[2]);
+		bool c = opaque(diagonal[0], diagonal[1], diagonal[2]);
+		ao[i] = a && b ? 0 : AO_MAX - a - b - c;
+	}
+	return ao;
+}
+
+/**
+ * @brief Compute the ambient occlusion of the corners of a face of a block of a world
+ * @param world The world
+ * @param pos The position of the block
+ * @param face The face
+ * @return The ambient occlusion of the corners of the face (0 to AO_MAX), in the order of Face_corners
+*/
+std::array<uint8_t, 4> World_face_ao(World* world, coords3 pos, Face face) {
+	return Face_ao(pos, face, [world](int x, int y, int z) {
+		if(!World_contains(x, y, z)) {
+			return false;
+		}
+		const Chunk* chunk = world->chunks[z / Z_CHUNK_SIZE][y / Y_CHUNK_SIZE][x / X_CHUNK_SIZE];
+		return (bool)(chunk->opacity[z % Z_CHUNK_SIZE] & ChunkMask_bit(x % X_CHUNK_SIZE, y % Y_CHUNK_SIZE));
+	});
+}
+
+/**
+ * @brief Check whether a face has occluded corners
+ * @param ao The ambient occlusion of the corners of the face
+ * @return Whether any corner is occluded, the face needing to be shaded per pixel
+*/
+bool Face_occluded(const std::array<uint8_t, 4>& ao) {
+	return (ao[0] & ao[1] & ao[2] & ao[3]) != AO_MAX;
+}
+
+#endif
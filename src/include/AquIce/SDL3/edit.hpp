@@ -0,0 +1,353 @@
+#ifndef __AQUICE_SDL3_EDIT_HPP__
+#define __AQUICE_SDL3_EDIT_HPP__
+
+#include <array>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "SDL.hpp"
+#include "world.hpp"
+#include "journal.hpp"
+
+static_assert(sizeof(Block) == 1, "The rows of blocks are written as bytes");
+
+/**
+ * @brief A bulk edit of a world, tracking the chunks written to
+ * @note The blocks are written straight into the chunks, their masks, versions and dirty flags being updated once per chunk by WorldEdit_commit
+ * @note When the world has a journal, the blocks of each chunk are copied before its first write so the edit can be recorded
+*/
+typedef struct WorldEdit {
+	/**
+	 * @brief The world
+	*/
+	World* world;
+	/**
+	 * @brief Whether each chunk was written to, indexed by World_chunk_index
+	*/
+	std::vector<bool> touched;
+	/**
+	 * @brief The blocks of the chunks written to before the edit, by World_chunk_index (only kept for the journal of the world)
+	*/
+	std::unordered_map<int, ChunkBlocks> before;
+} WorldEdit;
+
+/**
+ * @brief Start a bulk edit of a world
+ * @param world The world
+ * @return The bulk edit
+*/
+WorldEdit WorldEdit_new(World* world) {
+	return {world, std::vector<bool>(WORLD_CHUNK_COUNT, false), {}};
+}
+
+/**
+ * @brief Mark a chunk as written to by a bulk edit
+ * @param edit The bulk edit
+ * @param cx The x coordinate of the chunk
+ * @param cy The y coordinate of the chunk
+ * @param cz The z coordinate of the chunk
+ * @note Must be called before writing to the chunk, so its blocks can be kept for the journal
+*/
+void WorldEdit_touch(WorldEdit* edit, int cx, int cy, int cz) {
+	int index = World_chunk_index(cx, cy, cz);
+	if(edit->touched[index]) {
+		return;
+	}
+	if(edit->world->journal) {
+		edit->before[index] = edit->world->chunks[cz][cy][cx]->blocks;
+	}
+	edit->touched[index] = true;
+}
+
+/**
+ * @brief Clip a box to the world
+ * @param from A corner of the box
+ * @param to The opposite corner of the box
+ * @param min The lowest corner of the clipped box to fill
+ * @param max The highest corner of the clipped box to fill
+ * @return Whether the clipped box holds blocks
+ * @note Both corners are inside the box
+*/
+bool World_clip_box(coords3 from, coords3 to, coords3* min, coords3* max) {
+	*min = {std::max(std::min(from.x, to.x), 0), std::max(std::min(from.y, to.y), 0), std::max(std::min(from.z, to.z), 0)};
+	*max = {std::min(std::max(from.x, to.x), MAX_X_COORD - 1), std::min(std::max(from.y, to.y), MAX_Y_COORD - 1), std::min(std::max(from.z, to.z), MAX_Z_COORD - 1)};
+	return min->x <= max->x && min->y <= max->y && min->z <= max->z;
+}
+
+/**
+ * @brief Write a span of blocks along x
+ * @param edit The bulk edit
+ * @param x0 The x coordinate of the first block
+ * @param x1 The x coordinate of the last block
+ * @param y The y coordinate of the blocks
+ * @param z The z coordinate of the blocks
+ * @param block The block to write
+ * @note The span must be inside the world, each chunk row is written with one memset
+*/
+void WorldEdit_fill_span(WorldEdit* edit, int x0, int x1, int y, int z, Block block) {
+	int cy = y / Y_CHUNK_SIZE;
+	int cz = z / Z_CHUNK_SIZE;
+	for(int cx = x0 / X_CHUNK_SIZE; cx <= x1 / X_CHUNK_SIZE; cx++) {
+		int from = std::max(x0 - cx * X_CHUNK_SIZE, 0);
+		int to = std::min(x1 - cx * X_CHUNK_SIZE, X_CHUNK_SIZE - 1);
+		WorldEdit_touch(edit, cx, cy, cz);
+		Chunk* chunk = edit->world->chunks[cz][cy][cx];
+		std::memset(&chunk->blocks[z % Z_CHUNK_SIZE][y % Y_CHUNK_SIZE][from], block.id, to - from + 1);
+	}
+}
+
+/**
+ * @brief Finish a bulk edit
+ * @param edit The bulk edit
+ * @note The chunks written to get their masks recomputed and a new version, and they are marked dirty once along with their neighbors
+ * @note When the world has a journal, the changes are recorded in it as one entry
+*/
+void WorldEdit_commit(WorldEdit* edit) {
+	World* world = edit->world;
+	for(int index = 0; index < WORLD_CHUNK_COUNT; index++) {
+		if(!edit->touched[index]) {
+			continue;
+		}
+		int cx = index % X_CHUNK_COUNT;
+		int cy = index / X_CHUNK_COUNT % Y_CHUNK_COUNT;
+		int cz = index / (X_CHUNK_COUNT * Y_CHUNK_COUNT);
+		if(world->journal) {
+			coords3 pos = {world->origin.x + cx, world->origin.y + cy, world->origin.z + cz};
+			EditJournal_record(world->journal, pos, edit->before[index], World_get_chunk(world, cx, cy, cz)->blocks);
+		}
+		World_chunk_changed(world, cx, cy, cz);
+	}
+	if(world->journal) {
+		EditJournal_close(world->journal);
+	}
+	std::fill(edit->touched.begin(), edit->touched.end(), false);
+	edit->before.clear();
+}
+
+/**
+ * @brief Write a block
+ * @param edit The bulk edit
+ * @param x The x coordinate of the block
+ * @param y The y coordinate of the block
+ * @param z The z coordinate of the block
+ * @param block The block to write
+ * @note Blocks outside the world are ignored
+*/
+void WorldEdit_set_block(WorldEdit* edit, int x, int y, int z, Block block) {
+	if(World_contains(x, y, z)) {
+		WorldEdit_fill_span(edit, x, x, y, z, block);
+	}
+}
+
+/**
+ * @brief Set a block of the world
+ * @param world The world
+ * @param x The x coordinate of the block
+ * @param y The y coordinate of the block
+ * @param z The z coordinate of the block
+ * @param block The block
+ * @note Blocks outside the world or left unchanged are ignored, the chunk of the block (and its neighbors, diagonal ones included, if the block is on their border and its opacity changed) is marked dirty
+ * @note When the world has a journal, the write is recorded in it as an entry of its own, or as part of the group being recorded
+*/
+void World_set_block(World* world, int x, int y, int z, Block block) {
+	if(!World_contains(x, y, z)) {
+		return;
+	}
+	int cx = x / X_CHUNK_SIZE;
+	int cy = y / Y_CHUNK_SIZE;
+	int cz = z / Z_CHUNK_SIZE;
+	int lx = x % X_CHUNK_SIZE;
+	int ly = y % Y_CHUNK_SIZE;
+	int lz = z % Z_CHUNK_SIZE;
+	Chunk* chunk = world->chunks[cz][cy][cx];
+	Block before = chunk->blocks[lz][ly][lx];
+	if(before.id == block.id) {
+		return;
+	}
+	Chunk_set_block(chunk, lx, ly, lz, block, &world->palette);
+	if(world->journal) {
+		EditJournal_record_block(world->journal, {world->origin.x + cx, world->origin.y + cy, world->origin.z + cz}, lx + X_CHUNK_SIZE * (ly + Y_CHUNK_SIZE * lz), before, block);
+		EditJournal_close(world->journal);
+	}
+	World_mark_dirty(world, cx, cy, cz);
+
+	// A block on the border of its chunk changes the exposed faces of the neighbor, and the occlusion of the corners of the diagonal ones, through its opacity only
+	if(Block_is_opaque(&world->palette, before) != Block_is_opaque(&world->palette, block)) {
+		ChunkMask changed = {};
+		changed[lz] = ChunkMask_bit(lx, ly);
+		World_mark_dirty_around(world, cx, cy, cz, changed, true);
+	}
+}
+
+/**
+ * @brief Fill a box with a block
+ * @param edit The bulk edit
+ * @param from A corner of the box
+ * @param to The opposite corner of the box
+ * @param block The block
+ * @note The box is clipped to the world
+*/
+void WorldEdit_fill_box(WorldEdit* edit, coords3 from, coords3 to, Block block) {
+	coords3 min, max;
+	if(!World_clip_box(from, to, &min, &max)) {
+		return;
+	}
+	for(int z = min.z; z <= max.z; z++) {
+		for(int y = min.y; y <= max.y; y++) {
+			WorldEdit_fill_span(edit, min.x, max.x, y, z, block);
+		}
+	}
+}
+
+/**
+ * @brief Fill a box of a world with a block
+ * @param world The world
+ * @param from A corner of the box
+ * @param to The opposite corner of the box
+ * @param block The block
+ * @note The box is clipped to the world
+*/
+void World_fill_box(World* world, coords3 from, coords3 to, Block block) {
+	WorldEdit edit = WorldEdit_new(world);
+	WorldEdit_fill_box(&edit, from, to, block);
+	WorldEdit_commit(&edit);
+}
+
+/**
+ * @brief Fill the walls of a box of a world with a block, leaving its inside untouched
+ * @param world The world
+ * @param from A corner of the box
+ * @param to The opposite corner of the box
+ * @param block The block
+ * @note The box is clipped to the world after placing the walls
+*/
+void World_fill_hollow_box(World* world, coords3 from, coords3 to, Block block) {
+	coords3 min = {std::min(from.x, to.x), std::min(from.y, to.y), std::min(from.z, to.z)};
+	coords3 max = {std::max(from.x, to.x), std::max(from.y, to.y), std::max(from.z, to.z)};
+	coords3 cmin, cmax;
+	if(!World_clip_box(min, max, &cmin, &cmax)) {
+		return;
+	}
+	WorldEdit edit = WorldEdit_new(world);
+	for(int z = cmin.z; z <= cmax.z; z++) {
+		for(int y = cmin.y; y <= cmax.y; y++) {
+			if(z == min.z || z == max.z || y == min.y || y == max.y) {
+				WorldEdit_fill_span(&edit, cmin.x, cmax.x, y, z, block);
+				continue;
+			}
+			if(min.x == cmin.x) {
+				WorldEdit_fill_span(&edit, min.x, min.x, y, z, block);
+			}
+			if(max.x == cmax.x) {
+				WorldEdit_fill_span(&edit, max.x, max.x, y, z, block);
+			}
+		}
+	}
+	WorldEdit_commit(&edit);
+}
+
+/**
+ * @brief Replace a block by another in a box of a world
+ * @param world The world
+ * @param from A corner of the box
+ * @param to The opposite corner of the box
+ * @param block The block to replace
+ * @param replacement The block to replace it with
+ * @note The box is clipped to the world, only the chunks where the block is found are written to
+*/
+void World_replace_box(World* world, coords3 from, coords3 to, Block block, Block replacement) {
+	coords3 min, max;
+	if(block.id == replacement.id || !World_clip_box(from, to, &min, &max)) {
+		return;
+	}
+	WorldEdit edit = WorldEdit_new(world);
+	for(int cz = min.z / Z_CHUNK_SIZE; cz <= max.z / Z_CHUNK_SIZE; cz++) {
+		for(int cy = min.y / Y_CHUNK_SIZE; cy <= max.y / Y_CHUNK_SIZE; cy++) {
+			for(int cx = min.x / X_CHUNK_SIZE; cx <= max.x / X_CHUNK_SIZE; cx++) {
+				Chunk* chunk = World_get_chunk(world, cx, cy, cz);
+				// Empty chunks only hold air
+				if(block.id != 0 && Chunk_is_empty(chunk)) {
+					continue;
+				}
+				int x0 = std::max(min.x - cx * X_CHUNK_SIZE, 0), x1 = std::min(max.x - cx * X_CHUNK_SIZE, X_CHUNK_SIZE - 1);
+				int y0 = std::max(min.y - cy * Y_CHUNK_SIZE, 0), y1 = std::min(max.y - cy * Y_CHUNK_SIZE, Y_CHUNK_SIZE - 1);
+				int z0 = std::max(min.z - cz * Z_CHUNK_SIZE, 0), z1 = std::min(max.z - cz * Z_CHUNK_SIZE, Z_CHUNK_SIZE - 1);
+				// The chunk is only known to be written to once scanned, its blocks are kept for the journal beforehand
+				ChunkBlocks before;
+				if(world->journal) {
+					before = chunk->blocks;
+				}
+				bool found = false;
+				for(int z = z0; z <= z1; z++) {
+					for(int y = y0; y <= y1; y++) {
+						// Branchless select on the bytes of the row, which the compiler vectorizes
+						uint8_t* row = &chunk->blocks[z][y][0].id;
+						for(int x = x0; x <= x1; x++) {
+							bool match = row[x] == block.id;
+							found |= match;
+							row[x] = match ? replacement.id : row[x];
+						}
+					}
+				}
+				if(found) {
+					int index = World_chunk_index(cx, cy, cz);
+					edit.touched[index] = true;
+					if(world->journal) {
+						edit.before[index] = before;
+					}
+				}
+			}
+		}
+	}
+	WorldEdit_commit(&edit);
+}
+
+/**
+ * @brief Fill a sphere of a world with a block
+ * @param world The world
+ * @param center The center of the sphere
+ * @param radius The radius of the sphere
+ * @param block The block
+ * @param hollow Whether to only fill the shell of the sphere (one block thick), leaving its inside untouched
+ * @note A block is in the sphere when its center is at most radius away from the center of the center block
+*/
+void World_fill_sphere(World* world, coords3 center, double radius, Block block, bool hollow = false) {
+	coords3 min, max;
+	int r = (int)std::floor(radius);
+	if(radius < 0 || !World_clip_box({center.x - r, center.y - r, center.z - r}, {center.x + r, center.y + r, center.z + r}, &min, &max)) {
+		return;
+	}
+	WorldEdit edit = WorldEdit_new(world);
+	double inner = radius - 1;
+	for(int z = min.z; z <= max.z; z++) {
+		for(int y = min.y; y <= max.y; y++) {
+			// Each row of the sphere is one span, or two for the shell of a hollow one
+			double d2 = (double)(y - center.y) * (y - center.y) + (double)(z - center.z) * (z - center.z);
+			if(d2 > radius * radius) {
+				continue;
+			}
+			int half = (int)std::floor(std::sqrt(radius * radius - d2));
+			int x0 = std::max(center.x - half, min.x);
+			int x1 = std::min(center.x + half, max.x);
+			if(!hollow || inner < 0 || d2 > inner * inner) {
+				if(x0 <= x1) {
+					WorldEdit_fill_span(&edit, x0, x1, y, z, block);
+				}
+				continue;
+			}
+			int inner_half = (int)std::floor(std::sqrt(inner * inner - d2));
+			if(x0 <= std::min(center.x - inner_half - 1, x1)) {
+				WorldEdit_fill_span(&edit, x0, std::min(center.x - inner_half - 1, x1), y, z, block);
+			}
+			if(std::max(center.x + inner_half + 1, x0) <= x1) {
+				WorldEdit_fill_span(&edit, std::max(center.x + inner_half + 1, x0), x1, y, z, block);
+			}
+		}
+	}
+	WorldEdit_commit(&edit);
+}
+
+#endif
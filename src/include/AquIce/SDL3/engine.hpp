@@ -0,0 +1,46 @@
+#ifndef __AQUICE_SDL3_ENGINE_HPP__
+#define __AQUICE_SDL3_ENGINE_HPP__
+
+#include "SDL.hpp"
+#include "../utils/jobs.hpp"
+
+/**
+ * @brief The engine context, holding what every stage of the engine shares
+*/
+typedef struct SDL3_Engine {
+	/**
+	 * @brief The SDL3 configuration
+	*/
+	SDL3_Config config;
+	/**
+	 * @brief The job system meshing, generation, I/O and rasterization run on
+	*/
+	JobSystem* jobs;
+} SDL3_Engine;
+
+/**
+ * @brief Create a new engine context
+ * @param origin The origin of the SDL3 configuration
+ * @param size The size of the cube
+ * @param cam_vec The vector of the camera
+ * @param thread_count The number of worker threads (0 to follow the hardware concurrency)
+ * @return The engine context, to free with SDL3_Engine_free
+*/
+SDL3_Engine SDL3_Engine_new(coords origin, int size, coords3 cam_vec, int thread_count = 0) {
+	return SDL3_Engine{
+		SDL3_Config_new(origin, size, cam_vec),
+		JobSystem_new(thread_count)
+	};
+}
+
+/**
+ * @brief Free an engine context
+ * @param engine The engine context
+ * @note The jobs already queued are run first
+*/
+void SDL3_Engine_free(SDL3_Engine* engine) {
+	JobSystem_free(engine->jobs);
+	engine->jobs = nullptr;
+}
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef __AQUICE_SDL3_FRAME_HPP__
+#define __AQUICE_SDL3_FRAME_HPP__
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+#include "SDL.hpp"
+#include "world.hpp"
+
+/**
+ * @brief A published chunk, never written to again and freed once no frame refers to it
+*/
+typedef std::shared_ptr<const Chunk> ChunkRef;
+/**
+ * @brief The published shading of a chunk, never written to again and freed once no frame refers to it
+*/
+typedef std::shared_ptr<const ChunkState> ChunkStateRef;
+
+/**
+ * @brief An immutable snapshot of a world, which the render thread draws and the chunk mesher meshes while the world thread edits the world
+ * @note The world of the frame points at the chunks of the frame, it must only be read
+*/
+typedef struct WorldFrame {
+	/**
+	 * @brief The world as it was published
+	*/
+	World world;
+	/**
+	 * @brief The chunks of the frame, indexed by World_chunk_index, shared with the frames before and after it while unchanged
+	*/
+	std::vector<ChunkRef> chunks;
+	/**
+	 * @brief The shading of the chunks of the frame, indexed by World_chunk_index, shared like the chunks
+	*/
+	std::vector<ChunkStateRef> states;
+	/**
+	 * @brief The number of the frame, incremented on every publication
+	*/
+	uint64_t number;
+} WorldFrame;
+
+/**
+ * @brief A handle on a frame, kept alive as long as it is referenced
+*/
+typedef std::shared_ptr<WorldFrame> WorldFrameRef;
+
+/**
+ * @brief The publisher of the frames of a world
+*/
+typedef struct WorldPublisher {
+	/**
+	 * @brief The last frame published, swapped atomically
+	*/
+	WorldFrameRef current;
+	/**
+	 * @brief The chunks of the world each chunk of the last frame was copied from, indexed by World_chunk_index
+	*/
+	std::array<const Chunk*, WORLD_CHUNK_COUNT> sources;
+	/**
+	 * @brief The shading of the world each shading of the last frame was copied from, indexed by World_chunk_index
+	*/
+	std::array<const ChunkState*, WORLD_CHUNK_COUNT> state_sources;
+	/**
+	 * @brief The versions of the chunks of the world when they were copied, indexed by World_chunk_index
+	*/
+	std::array<uint32_t, WORLD_CHUNK_COUNT> versions;
+	/**
+	 * @brief The light versions of the shading of the world when it was copied, indexed by World_chunk_index
+	*/
+	std::array<uint32_t, WORLD_CHUNK_COUNT> light_versions;
+	/**
+	 * @brief The number of chunks copied by the last publication
+	*/
+	int copied;
+} WorldPublisher;
+
+/**
+ * @brief Create a new world publisher, with no frame yet
+ * @return The world publisher pointer
+*/
+WorldPublisher* WorldPublisher_new() {
+	WorldPublisher* publisher = new WorldPublisher();
+	publisher->sources.fill(nullptr);
+	publisher->state_sources.fill(nullptr);
+	publisher->versions.fill(0);
+	publisher->light_versions.fill(0);
+	publisher->copied = 0;
+	return publisher;
+}
+
+/**
+ * @brief Free a world publisher
+ * @param publisher The world publisher pointer
+ * @note The frames still referenced stay valid
+*/
+void WorldPublisher_free(WorldPublisher* publisher) {
+	delete publisher;
+}
+
+/**
+ * @brief Get the last frame published
+ * @param publisher The world publisher
+ * @return The frame (null before the first publication), which stays the same however long it is held
+ * @note Can be called from any thread
+*/
+WorldFrameRef WorldPublisher_acquire(WorldPublisher* publisher) {
+	return std::atomic_load(&publisher->current);
+}
+
+/**
+ * @brief Publish the current state of a world as a new frame
+ * @param publisher The world publisher
+ * @param world The world
+ * @note Only called by the world thread, between two batches of edits
+ * @note Only the chunks written to or replaced since the last frame are copied, and only the shading of the ones relit, the others are shared with it
+*/
+void WorldPublisher_publish(WorldPublisher* publisher, World* world) {
+	WorldFrameRef previous = std::atomic_load(&publisher->current);
+	// Moving the window replaces every chunk of the world
+	bool moved = !previous
+		|| previous->world.origin.x != world->origin.x
+		|| previous->world.origin.y != world->origin.y
+		|| previous->world.origin.z != world->origin.z;
+
+	std::shared_ptr<WorldFrame> frame = std::make_shared<WorldFrame>();
+	frame->number = previous ? previous->number + 1 : 0;
+	frame->world.origin = world->origin;
+	frame->world.palette = world->palette;
+	frame->chunks.resize(WORLD_CHUNK_COUNT);
+	frame->states.resize(WORLD_CHUNK_COUNT);
+	publisher->copied = 0;
+	for(int cz = 0; cz < Z_CHUNK_COUNT; cz++) {
+		for(int cy = 0; cy < Y_CHUNK_COUNT; cy++) {
+			for(int cx = 0; cx < X_CHUNK_COUNT; cx++) {
+				int index = World_chunk_index(cx, cy, cz);
+				const Chunk* chunk = World_get_chunk(world, cx, cy, cz);
+				if(moved || publisher->sources[index] != chunk || publisher->versions[index] != chunk->version) {
+					frame->chunks[index] = std::make_shared<const Chunk>(*chunk);
+					publisher->sources[index] = chunk;
+					publisher->versions[index] = chunk->version;
+					publisher->copied++;
+				} else {
+					frame->chunks[index] = previous->chunks[index];
+				}
+				const ChunkState* state = World_get_state(world, cx, cy, cz);
+				if(moved || publisher->state_sources[index] != state || publisher->light_versions[index] != state->light_version) {
+					frame->states[index] = std::make_shared<const ChunkState>(*state);
+					publisher->state_sources[index] = state;
+					publisher->light_versions[index] = state->light_version;
+				} else {
+					frame->states[index] = previous->states[index];
+				}
+				// The chunks of a frame are never written to, the world of the frame only reads them
+				frame->world.chunks[cz][cy][cx] = const_cast<Chunk*>(frame->chunks[index].get());
+				frame->world.states[index] = const_cast<ChunkState*>(frame->states[index].get());
+			}
+		}
+	}
+	std::atomic_store(&publisher->current, frame);
+}
+
+#endif
@@ -0,0 +1,524 @@
+#ifndef __AQUICE_SDL3_JOURNAL_HPP__
+#define __AQUICE_SDL3_JOURNAL_HPP__
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+#include "SDL.hpp"
+#include "world.hpp"
+#include "stream.hpp"
+
+/**
+ * @brief The default number of bytes of deltas an edit journal keeps in memory
+*/
+#define EDIT_JOURNAL_BUDGET (64 << 20)
+/**
+ * @brief The size of a run of a chunk delta: its start and length as two little-endian uint16, then the old and the new block
+*/
+#define JOURNAL_RUN_SIZE 6
+
+/**
+ * @brief The changes an edit made to a chunk
+*/
+typedef struct JournalChunk {
+	/**
+	 * @brief The position of the chunk in the unbounded world, in chunks
+	*/
+	coords3 pos;
+	/**
+	 * @brief The runs of blocks changed, in memory order, each one turning a single old block into a single new block
+	*/
+	std::vector<uint8_t> runs;
+} JournalChunk;
+
+/**
+ * @brief An edit recorded in a journal, undone and redone as a whole
+*/
+typedef struct JournalEntry {
+	/**
+	 * @brief The chunks changed by the edit (empty while the entry is spilled)
+	*/
+	std::vector<JournalChunk> chunks;
+	/**
+	 * @brief The number of bytes the entry takes in memory once loaded
+	*/
+	size_t bytes;
+	/**
+	 * @brief The offset of the entry in the spill file (-1 while it is in memory)
+	*/
+	long spill_offset;
+} JournalEntry;
+
+/**
+ * @brief A journal of the bulk edits of a world, storing per-chunk deltas to undo and redo them
+ * @note The oldest entries are spilled to a file once the journal takes more memory than its budget
+*/
+typedef struct EditJournal {
+	/**
+	 * @brief The entries, from the oldest to the newest
+	*/
+	std::deque<JournalEntry> entries;
+	/**
+	 * @brief The number of entries applied to the world, the ones after them being redone by World_redo
+	*/
+	size_t applied;
+	/**
+	 * @brief The number of bytes the entries in memory take
+	*/
+	size_t memory;
+	/**
+	 * @brief The number of bytes the entries may take in memory
+	*/
+	size_t budget;
+	/**
+	 * @brief The path of the spill file (empty to drop the oldest entries instead)
+	*/
+	std::string spill_path;
+	/**
+	 * @brief The spill file, opened on the first spill
+	*/
+	FILE* spill;
+	/**
+	 * @brief The number of entries in the spill file, the oldest ones
+	*/
+	size_t spilled;
+	/**
+	 * @brief The depth of the nested groups of edits being recorded as one entry
+	*/
+	int group;
+	/**
+	 * @brief Whether the last entry still collects the edits being recorded
+	*/
+	bool open;
+	/**
+	 * @brief The chunks of the open entry, by position
+	*/
+	std::unordered_map<coords3, size_t, ChunkPosHash, ChunkPosEqual> open_chunks;
+} EditJournal;
+
+/**
+ * @brief Create a new edit journal
+ * @param budget The number of bytes of deltas the journal keeps in memory
+ * @param spill_path The path of the file the oldest entries are spilled to (empty to drop them instead)
+ * @return The edit journal pointer
+ * @note Set it as the journal of a world to record its bulk edits
+*/
+EditJournal* EditJournal_new(size_t budget = EDIT_JOURNAL_BUDGET, const std::string& spill_path = "") {
+	EditJournal* journal = new EditJournal();
+	journal->applied = 0;
+	journal->memory = 0;
+	journal->budget = budget;
+	journal->spill_path = spill_path;
+	journal->spill = nullptr;
+	journal->spilled = 0;
+	journal->group = 0;
+	journal->open = false;
+	return journal;
+}
+
+/**
+ * @brief Free an edit journal, removing its spill file
+ * @param journal The edit journal pointer
+*/
+void EditJournal_free(EditJournal* journal) {
+	if(journal->spill) {
+		std::fclose(journal->spill);
+		std::remove(journal->spill_path.c_str());
+	}
+	delete journal;
+}
+
+/**
+ * @brief Encode the changes between two versions of the blocks of a chunk
+ * @param before The blocks before the edit
+ * @param after The blocks after the edit
+ * @param runs The runs to append to
+ * @note A run ends where a block is unchanged or where its old or new block differs from the ones of the run,
+ * @note so a bulk fill over uniform ground takes a few runs per chunk
+*/
+void JournalChunk_encode(const ChunkBlocks& before, const ChunkBlocks& after, std::vector<uint8_t>* runs) {
+	const uint8_t* old_ids = &before[0][0][0].id;
+	const uint8_t* new_ids = &after[0][0][0].id;
+	int count = X_CHUNK_SIZE * Y_CHUNK_SIZE * Z_CHUNK_SIZE;
+	int i = 0;
+	while(i < count) {
+		if(old_ids[i] == new_ids[i]) {
+			i++;
+			continue;
+		}
+		int start = i;
+		uint8_t old_id = old_ids[i], new_id = new_ids[i];
+		while(i < count && old_ids[i] == old_id && new_ids[i] == new_id) {
+			i++;
+		}
+		int length = i - start;
+		uint8_t run[JOURNAL_RUN_SIZE] = {(uint8_t)start, (uint8_t)(start >> 8), (uint8_t)length, (uint8_t)(length >> 8), old_id, new_id};
+		runs->insert(runs->end(), run, run + JOURNAL_RUN_SIZE);
+	}
+}
+
+/**
+ * @brief Write the old or the new blocks of the runs of a chunk delta
+ * @param runs The runs
+ * @param blocks The blocks to write to
+ * @param undo Whether to write the old blocks rather than the new ones
+ * @note Each run is written with one memset
+*/
+void JournalChunk_apply(const std::vector<uint8_t>& runs, ChunkBlocks* blocks, bool undo) {
+	uint8_t* ids = &(*blocks)[0][0][0].id;
+	for(size_t i = 0; i + JOURNAL_RUN_SIZE <= runs.size(); i += JOURNAL_RUN_SIZE) {
+		int start = runs[i] | runs[i + 1] << 8;
+		int length = runs[i + 2] | runs[i + 3] << 8;
+		std::memset(ids + start, undo ? runs[i + 4] : runs[i + 5], length);
+	}
+}
+
+/**
+ * @brief Get the number of bytes a chunk delta takes in memory
+ * @param chunk The chunk delta
+ * @return The number of bytes
+*/
+size_t JournalChunk_bytes(const JournalChunk& chunk) {
+	return sizeof(JournalChunk) + chunk.runs.capacity();
+}
+
+/**
+ * @brief Spill the oldest entries of a journal in memory to its spill file until it fits its budget
+ * @param journal The edit journal
+ * @note Without a spill file (or when it cannot be written) the oldest entries are dropped instead, the newest entry is always kept
+*/
+void EditJournal_trim(EditJournal* journal) {
+	while(journal->memory > journal->budget && journal->spilled + 1 < journal->entries.size()) {
+		JournalEntry& entry = journal->entries[journal->spilled];
+		if(!journal->spill && !journal->spill_path.empty()) {
+			journal->spill = std::fopen(journal->spill_path.c_str(), "wb+");
+		}
+		bool written = journal->spill && std::fseek(journal->spill, 0, SEEK_END) == 0;
+		long offset = written ? std::ftell(journal->spill) : -1;
+		if(written) {
+			uint32_t count = entry.chunks.size();
+			written = offset >= 0 && std::fwrite(&count, sizeof(count), 1, journal->spill) == 1;
+			for(const JournalChunk& chunk : entry.chunks) {
+				int32_t header[4] = {chunk.pos.x, chunk.pos.y, chunk.pos.z, (int32_t)chunk.runs.size()};
+				written = written
+					&& std::fwrite(header, sizeof(header), 1, journal->spill) == 1
+					&& std::fwrite(chunk.runs.data(), 1, chunk.runs.size(), journal->spill) == chunk.runs.size();
+			}
+		}
+		journal->memory -= entry.bytes;
+		if(written) {
+			entry.chunks = std::vector<JournalChunk>();
+			entry.spill_offset = offset;
+			journal->spilled++;
+		} else {
+			// Nowhere to spill it, it can no longer be undone and neither can the entries before it
+			journal->entries.erase(journal->entries.begin(), journal->entries.begin() + journal->spilled + 1);
+			journal->applied -= journal->spilled + 1;
+			journal->spilled = 0;
+		}
+	}
+}
+
+/**
+ * @brief Read the chunks of a spilled entry back
+ * @param journal The edit journal
+ * @param entry The spilled entry
+ * @param chunks The chunks to fill
+ * @return Whether the entry could be read
+*/
+bool EditJournal_load(EditJournal* journal, const JournalEntry& entry, std::vector<JournalChunk>* chunks) {
+	uint32_t count = 0;
+	if(!journal->spill || std::fseek(journal->spill, entry.spill_offset, SEEK_SET) != 0 || std::fread(&count, sizeof(count), 1, journal->spill) != 1) {
+		return false;
+	}
+	chunks->resize(count);
+	for(JournalChunk& chunk : *chunks) {
+		int32_t header[4];
+		if(std::fread(header, sizeof(header), 1, journal->spill) != 1 || header[3] < 0) {
+			return false;
+		}
+		chunk.pos = {header[0], header[1], header[2]};
+		chunk.runs.resize(header[3]);
+		if(std::fread(chunk.runs.data(), 1, chunk.runs.size(), journal->spill) != chunk.runs.size()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Start a new entry of a journal, unless one is open
+ * @param journal The edit journal
+ * @note The entries undone are dropped, a new edit making them unreachable
+*/
+void EditJournal_open(EditJournal* journal) {
+	if(!journal->open) {
+		// A new edit makes the undone ones unreachable
+		while(journal->entries.size() > journal->applied) {
+			if(journal->entries.back().spill_offset < 0) {
+				journal->memory -= journal->entries.back().bytes;
+			}
+			journal->entries.pop_back();
+		}
+		journal->spilled = std::min(journal->spilled, journal->entries.size());
+		journal->entries.push_back({{}, 0, -1});
+		journal->applied++;
+		journal->open = true;
+		journal->open_chunks.clear();
+	}
+}
+
+/**
+ * @brief Add a chunk delta to the open entry of a journal
+ * @param journal The edit journal
+ * @param chunk The chunk delta, not in the entry yet
+*/
+void EditJournal_add(EditJournal* journal, JournalChunk chunk) {
+	JournalEntry& entry = journal->entries.back();
+	chunk.runs.shrink_to_fit();
+	journal->open_chunks[chunk.pos] = entry.chunks.size();
+	entry.bytes += JournalChunk_bytes(chunk);
+	journal->memory += JournalChunk_bytes(chunk);
+	entry.chunks.push_back(std::move(chunk));
+}
+
+/**
+ * @brief Record the changes an edit made to a chunk
+ * @param journal The edit journal
+ * @param pos The position of the chunk in the unbounded world, in chunks
+ * @param before The blocks of the chunk before the edit
+ * @param after The blocks of the chunk after the edit
+ * @note The changes go to the open entry, a new one being started (and the entries undone dropped) if there is none.
+ * @note A chunk already in the open entry gets one delta from its blocks before the first edit to its blocks after the last one.
+*/
+void EditJournal_record(EditJournal* journal, coords3 pos, const ChunkBlocks& before, const ChunkBlocks& after) {
+	EditJournal_open(journal);
+	JournalEntry& entry = journal->entries.back();
+	auto found = journal->open_chunks.find(pos);
+	if(found == journal->open_chunks.end()) {
+		JournalChunk chunk = {pos, {}};
+		JournalChunk_encode(before, after, &chunk.runs);
+		if(!chunk.runs.empty()) {
+			EditJournal_add(journal, std::move(chunk));
+		}
+		return;
+	}
+	// Coalesce with the earlier edits of the entry: rebuild the blocks before them, then diff against the latest ones
+	JournalChunk& chunk = entry.chunks[found->second];
+	ChunkBlocks original = before;
+	JournalChunk_apply(chunk.runs, &original, true);
+	entry.bytes -= JournalChunk_bytes(chunk);
+	journal->memory -= JournalChunk_bytes(chunk);
+	chunk.runs.clear();
+	JournalChunk_encode(original, after, &chunk.runs);
+	chunk.runs.shrink_to_fit();
+	entry.bytes += JournalChunk_bytes(chunk);
+	journal->memory += JournalChunk_bytes(chunk);
+}
+
+/**
+ * @brief Record the change of one block of a chunk
+ * @param journal The edit journal
+ * @param pos The position of the chunk in the unbounded world, in chunks
+ * @param index The index of the block in the chunk, x + X_CHUNK_SIZE * (y + Y_CHUNK_SIZE * z)
+ * @param before The block before the edit
+ * @param after The block after the edit
+ * @note Same as EditJournal_record without copying nor diffing the blocks of the chunk: the block is spliced into the runs of the chunk
+*/
+void EditJournal_record_block(EditJournal* journal, coords3 pos, int index, Block before, Block after) {
+	EditJournal_open(journal);
+	JournalEntry& entry = journal->entries.back();
+	std::vector<uint8_t> runs;
+	auto push = [&runs](int start, int length, uint8_t old_id, uint8_t new_id) {
+		if(length > 0 && old_id != new_id) {
+			uint8_t run[JOURNAL_RUN_SIZE] = {(uint8_t)start, (uint8_t)(start >> 8), (uint8_t)length, (uint8_t)(length >> 8), old_id, new_id};
+			runs.insert(runs.end(), run, run + JOURNAL_RUN_SIZE);
+		}
+	};
+	auto found = journal->open_chunks.find(pos);
+	if(found == journal->open_chunks.end()) {
+		push(index, 1, before.id, after.id);
+		if(!runs.empty()) {
+			EditJournal_add(journal, {pos, std::move(runs)});
+		}
+		return;
+	}
+	// The runs are sorted and disjoint: the one holding the block is split around it, the block keeping its old id from before the entry
+	JournalChunk& chunk = entry.chunks[found->second];
+	runs.reserve(chunk.runs.size() + 2 * JOURNAL_RUN_SIZE);
+	bool placed = false;
+	for(size_t i = 0; i + JOURNAL_RUN_SIZE <= chunk.runs.size(); i += JOURNAL_RUN_SIZE) {
+		int start = chunk.runs[i] | chunk.runs[i + 1] << 8;
+		int length = chunk.runs[i + 2] | chunk.runs[i + 3] << 8;
+		uint8_t old_id = chunk.runs[i + 4], new_id = chunk.runs[i + 5];
+		if(!placed && index < start) {
+			push(index, 1, before.id, after.id);
+			placed = true;
+		}
+		if(index >= start && index < start + length) {
+			push(start, index - start, old_id, new_id);
+			push(index, 1, old_id, after.id);
+			push(index + 1, start + length - index - 1, old_id, new_id);
+			placed = true;
+		} else {
+			push(start, length, old_id, new_id);
+		}
+	}
+	if(!placed) {
+		push(index, 1, before.id, after.id);
+	}
+	runs.shrink_to_fit();
+	entry.bytes -= JournalChunk_bytes(chunk);
+	journal->memory -= JournalChunk_bytes(chunk);
+	chunk.runs = std::move(runs);
+	entry.bytes += JournalChunk_bytes(chunk);
+	journal->memory += JournalChunk_bytes(chunk);
+}
+
+/**
+ * @brief Close the open entry of a journal unless a group of edits is being recorded
+ * @param journal The edit journal
+ * @note Called by WorldEdit_commit, an entry without changes being dropped
+*/
+void EditJournal_close(EditJournal* journal) {
+	if(!journal->open || journal->group > 0) {
+		return;
+	}
+	journal->open = false;
+	journal->open_chunks.clear();
+	if(journal->entries.back().chunks.empty()) {
+		journal->entries.pop_back();
+		journal->applied--;
+	}
+	EditJournal_trim(journal);
+}
+
+/**
+ * @brief Start recording the following edits as one entry, undone and redone at once
+ * @param journal The edit journal
+ * @note Groups nest, the entry being closed by the outermost EditJournal_end_group
+*/
+void EditJournal_begin_group(EditJournal* journal) {
+	journal->group++;
+}
+
+/**
+ * @brief Stop recording the edits of a group as one entry
+ * @param journal The edit journal
+*/
+void EditJournal_end_group(EditJournal* journal) {
+	if(journal->group > 0 && --journal->group == 0) {
+		EditJournal_close(journal);
+	}
+}
+
+/**
+ * @brief Forget every entry of a journal and empty its spill file
+ * @param journal The edit journal
+*/
+void EditJournal_clear(EditJournal* journal) {
+	journal->entries.clear();
+	journal->open_chunks.clear();
+	journal->applied = 0;
+	journal->memory = 0;
+	journal->spilled = 0;
+	journal->group = 0;
+	journal->open = false;
+	if(journal->spill) {
+		std::fclose(journal->spill);
+		journal->spill = std::fopen(journal->spill_path.c_str(), "wb+");
+	}
+}
+
+/**
+ * @brief Write the old or the new blocks of an entry of a journal to a world
+ * @param world The world
+ * @param chunks The chunks of the entry
+ * @param undo Whether to write the old blocks rather than the new ones
+ * @return Whether every chunk of the entry is in the world window, nothing being written otherwise
+*/
+bool World_apply_journal(World* world, const std::vector<JournalChunk>& chunks, bool undo) {
+	for(const JournalChunk& delta : chunks) {
+		if(!World_get_chunk(world, delta.pos.x - world->origin.x, delta.pos.y - world->origin.y, delta.pos.z - world->origin.z)) {
+			return false;
+		}
+	}
+	for(const JournalChunk& delta : chunks) {
+		int cx = delta.pos.x - world->origin.x;
+		int cy = delta.pos.y - world->origin.y;
+		int cz = delta.pos.z - world->origin.z;
+		JournalChunk_apply(delta.runs, &World_get_chunk(world, cx, cy, cz)->blocks, undo);
+		World_chunk_changed(world, cx, cy, cz);
+	}
+	return true;
+}
+
+/**
+ * @brief Undo or redo an entry of the journal of a world
+ * @param world The world
+ * @param index The index of the entry
+ * @param undo Whether to undo the entry rather than redo it
+ * @return Whether the entry could be read and every one of its chunks is in the world window, nothing being written otherwise
+*/
+bool World_replay_journal(World* world, size_t index, bool undo) {
+	EditJournal* journal = world->journal;
+	const JournalEntry& entry = journal->entries[index];
+	if(entry.spill_offset < 0) {
+		return World_apply_journal(world, entry.chunks, undo);
+	}
+	// Spilled entries are read back for the time of the replay only, so the journal stays within its budget
+	std::vector<JournalChunk> chunks;
+	if(!EditJournal_load(journal, entry, &chunks)) {
+		return false;
+	}
+	return World_apply_journal(world, chunks, undo);
+}
+
+/**
+ * @brief Undo the last edit of a world recorded in its journal
+ * @param world The world
+ * @return Whether an edit was undone
+ * @note Costs as much as the edit did: one memset per run, then one mask update per chunk
+ * @note A group of edits being recorded is ended first
+ * @note An edit reaching outside the world window is not undone (nor skipped) until the window is moved back over it
+*/
+bool World_undo(World* world) {
+	EditJournal* journal = world->journal;
+	if(!journal) {
+		return false;
+	}
+	journal->group = 0;
+	EditJournal_close(journal);
+	if(journal->applied == 0 || !World_replay_journal(world, journal->applied - 1, true)) {
+		return false;
+	}
+	journal->applied--;
+	return true;
+}
+
+/**
+ * @brief Redo the last edit of a world undone
+ * @param world The world
+ * @return Whether an edit was redone
+ * @note An edit reaching outside the world window is not redone (nor skipped) until the window is moved back over it
+*/
+bool World_redo(World* world) {
+	EditJournal* journal = world->journal;
+	if(!journal) {
+		return false;
+	}
+	journal->group = 0;
+	EditJournal_close(journal);
+	if(journal->applied == journal->entries.size() || !World_replay_journal(world, journal->applied, false)) {
+		return false;
+	}
+	journal->applied++;
+	return true;
+}
+
+#endif
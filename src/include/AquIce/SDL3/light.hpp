@@ -0,0 +1,658 @@
+#ifndef __AQUICE_SDL3_LIGHT_HPP__
+#define __AQUICE_SDL3_LIGHT_HPP__
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+
+#include "SDL.hpp"
+#include "world.hpp"
+#include "../utils/jobs.hpp"
+
+/**
+ * @brief The brightness of the faces in the dark, out of 255 for the ones in full light
+*/
+#define LIGHT_AMBIENT 72
+
+/**
+ * @brief A block whose light is being removed, with the level it had
+*/
+typedef struct LightNode {
+	/**
+	 * @brief The index of the block, x + MAX_X_COORD * (y + MAX_Y_COORD * z)
+	*/
+	int index;
+	/**
+	 * @brief The light level the block had
+	*/
+	uint8_t level;
+} LightNode;
+
+/**
+ * @brief The blocks whose light is removed or spread in an area of a world, far enough from the other areas for their searches to run in parallel
+*/
+typedef struct LightRegion {
+	/**
+	 * @brief The blocks whose light is being removed
+	*/
+	std::vector<LightNode> removals;
+	/**
+	 * @brief The blocks whose light is being spread to their neighbors
+	*/
+	std::vector<int> additions;
+	/**
+	 * @brief The blocks whose light changed, to flag in the chunk tracker once the searches are done
+	*/
+	std::vector<int> touched;
+} LightRegion;
+
+/**
+ * @brief The sky lighting of a world, propagated with breadth-first searches as the opacity of its blocks changes
+ * @note The blocks open to the sky get LIGHT_MAX, which goes down through the blocks that are not opaque without fading
+ * @note and loses one level per block in every other direction. Opaque blocks are dark.
+*/
+typedef struct WorldLighting {
+	/**
+	 * @brief The job system the relights and the light regions run on
+	*/
+	JobSystem* jobs;
+	/**
+	 * @brief The chunks of the world the light was computed for, and the blocks whose light changed during the update
+	*/
+	ChunkTracker* tracker;
+	/**
+	 * @brief The blocks whose light is being removed
+	*/
+	std::vector<LightNode> removals;
+	/**
+	 * @brief The blocks whose light is being spread to their neighbors
+	*/
+	std::vector<int> additions;
+	/**
+	 * @brief The number of chunks whose light changed during the last update
+	*/
+	int relit;
+} WorldLighting;
+
+/**
+ * @brief Create a new world lighting
+ * @param jobs The job system the relights and the light regions run on
+ * @return The world lighting pointer, the first update computing the light of the whole world
+*/
+WorldLighting* WorldLighting_new(JobSystem* jobs) {
+	WorldLighting* lighting = new WorldLighting();
+	lighting->jobs = jobs;
+	lighting->tracker = ChunkTracker_new();
+	lighting->relit = 0;
+	return lighting;
+}
+
+/**
+ * @brief Free a world lighting
+ * @param lighting The world lighting pointer
+*/
+void WorldLighting_free(WorldLighting* lighting) {
+	ChunkTracker_free(lighting->tracker);
+	delete lighting;
+}
+
+/**
+ * @brief Get the light level of a block, looking into the neighbors of its chunk on the border
+ * @param state The shading of the chunk
+ * @param nlight The light of the neighbors of the chunk, indexed by the face they touch
+ * @param x The x coordinate of the block in the chunk (-1 to X_CHUNK_SIZE)
+ * @param y The y coordinate of the block in the chunk (-1 to Y_CHUNK_SIZE)
+ * @param z The z coordinate of the block in the chunk (-1 to Z_CHUNK_SIZE)
+ * @return The light level of the block
+ * @note At most one coordinate may be outside the chunk
+*/
+uint8_t ChunkState_light_at(const ChunkState* state, const std::array<ChunkLight, FACE_COUNT>& nlight, int x, int y, int z) {
+	if(x < 0) {
+		return nlight[FACE_NEG_X][z][y][X_CHUNK_SIZE - 1];
+	}
+	if(x >= X_CHUNK_SIZE) {
+		return nlight[FACE_POS_X][z][y][0];
+	}
+	if(y < 0) {
+		return nlight[FACE_NEG_Y][z][Y_CHUNK_SIZE - 1][x];
+	}
+	if(y >= Y_CHUNK_SIZE) {
+		return nlight[FACE_POS_Y][z][0][x];
+	}
+	if(z < 0) {
+		return nlight[FACE_NEG_Z][Z_CHUNK_SIZE - 1][y][x];
+	}
+	if(z >= Z_CHUNK_SIZE) {
+		return nlight[FACE_POS_Z][0][y][x];
+	}
+	return state->light[z][y][x];
+}
+
+/**
+ * @brief Get the light of the neighbors of a chunk
+ * @param neighbors The shading of the neighboring chunks, indexed by the face they touch (nullptr outside the world)
+ * @return The light of the neighbors, indexed by the face they touch
+ * @note Outside the world is open to the sky
+*/
+std::array<ChunkLight, FACE_COUNT> ChunkState_neighbors_light(const std::array<const ChunkState*, FACE_COUNT>& neighbors) {
+	std::array<ChunkLight, FACE_COUNT> nlight;
+	for(int face = 0; face < FACE_COUNT; face++) {
+		if(neighbors[face]) {
+			nlight[face] = neighbors[face]->light;
+		} else {
+			for(auto& layer : nlight[face]) {
+				for(auto& bar : layer) {
+					bar.fill(LIGHT_MAX);
+				}
+			}
+		}
+	}
+	return nlight;
+}
+
+/**
+ * @brief Get the brightness of a light level
+ * @param level The light level
+ * @return The brightness, out of 255, from LIGHT_AMBIENT in the dark
+*/
+int Light_factor(int level) {
+	return LIGHT_AMBIENT + (255 - LIGHT_AMBIENT) * level / LIGHT_MAX;
+}
+
+/**
+ * @brief Get the light a face of a block of a world receives
+ * @param world The world
+ * @param pos The position of the block
+ * @param face The face
+ * @return The light level of the block in front of the face (LIGHT_MAX outside the world)
+*/
+uint8_t World_face_light(World* world, coords3 pos, Face face) {
+	coords3 normal = Face_normal(face);
+	int x = pos.x + normal.x, y = pos.y + normal.y, z = pos.z + normal.z;
+	if(!World_contains(x, y, z)) {
+		return LIGHT_MAX;
+	}
+	return world->states[World_chunk_index(x / X_CHUNK_SIZE, y / Y_CHUNK_SIZE, z / Z_CHUNK_SIZE)]->light[z % Z_CHUNK_SIZE][y % Y_CHUNK_SIZE][x % X_CHUNK_SIZE];
+}
+
+/**
+ * @brief Get the light level of a block of a world
+ * @param world The world
+ * @param index The index of the block, x + MAX_X_COORD * (y + MAX_Y_COORD * z)
+ * @return The light level of the block
+*/
+uint8_t& World_light(World* world, int index) {
+	int x = index % MAX_X_COORD, y = index / MAX_X_COORD % MAX_Y_COORD, z = index / (MAX_X_COORD * MAX_Y_COORD);
+	return world->states[World_chunk_index(x / X_CHUNK_SIZE, y / Y_CHUNK_SIZE, z / Z_CHUNK_SIZE)]->light[z % Z_CHUNK_SIZE][y % Y_CHUNK_SIZE][x % X_CHUNK_SIZE];
+}
+
+/**
+ * @brief Check whether a block of a world is opaque, from the opacity mask of its chunk
+ * @param world The world
+ * @param index The index of the block, x + MAX_X_COORD * (y + MAX_Y_COORD * z)
+ * @return Whether the block is opaque
+*/
+bool World_light_blocked(World* world, int index) {
+	int x = index % MAX_X_COORD, y = index / MAX_X_COORD % MAX_Y_COORD, z = index / (MAX_X_COORD * MAX_Y_COORD);
+	const Chunk* chunk = world->chunks[z / Z_CHUNK_SIZE][y / Y_CHUNK_SIZE][x / X_CHUNK_SIZE];
+	return chunk->opacity[z % Z_CHUNK_SIZE] & ChunkMask_bit(x % X_CHUNK_SIZE, y % Y_CHUNK_SIZE);
+}
+
+/**
+ * @brief Get the neighbor of a block of a world in a direction
+ * @param index The index of the block, x + MAX_X_COORD * (y + MAX_Y_COORD * z)
+ * @param face The direction, as the face of the block the neighbor touches
+ * @param min The lowest corner of the blocks to stay in
+ * @param max The highest corner of the blocks to stay in
+ * @return The index of the neighbor, or -1 if it is outside the blocks to stay in
+*/
+int World_light_neighbor(int index, Face face, coords3 min, coords3 max) {
+	int x = index % MAX_X_COORD, y = index / MAX_X_COORD % MAX_Y_COORD, z = index / (MAX_X_COORD * MAX_Y_COORD);
+	switch(face) {
+		case FACE_NEG_X: return x > min.x ? index - 1 : -1;
+		case FACE_POS_X: return x < max.x ? index + 1 : -1;
+		case FACE_NEG_Y: return y > min.y ? index - MAX_X_COORD : -1;
+		case FACE_POS_Y: return y < max.y ? index + MAX_X_COORD : -1;
+		case FACE_NEG_Z: return z > min.z ? index - MAX_X_COORD * MAX_Y_COORD : -1;
+		default: return z < max.z ? index + MAX_X_COORD * MAX_Y_COORD : -1;
+	}
+}
+
+/**
+ * @brief Flag a block of a world as relit
+ * @param lighting The world lighting
+ * @param index The index of the block, x + MAX_X_COORD * (y + MAX_Y_COORD * z)
+*/
+void WorldLighting_touch(WorldLighting* lighting, int index) {
+	ChunkTracker_touch(lighting->tracker, index % MAX_X_COORD, index / MAX_X_COORD % MAX_Y_COORD, index / (MAX_X_COORD * MAX_Y_COORD));
+}
+
+/**
+ * @brief Spread the light of blocks to their neighbors, breadth first
+ * @param world The world
+ * @param additions The blocks to spread the light of, emptied
+ * @param min The lowest corner of the blocks to stay in
+ * @param max The highest corner of the blocks to stay in
+ * @param touched The blocks relit to add to (nullptr for none)
+*/
+void World_spread_light(World* world, std::vector<int>* additions, coords3 min, coords3 max, std::vector<int>* touched = nullptr) {
+	for(size_t head = 0; head < additions->size(); head++) {
+		int index = (*additions)[head];
+		int level = World_light(world, index);
+		if(level <= 1) {
+			continue;
+		}
+		for(int face = 0; face < FACE_COUNT; face++) {
+			int neighbor = World_light_neighbor(index, (Face)face, min, max);
+			if(neighbor < 0 || World_light_blocked(world, neighbor)) {
+				continue;
+			}
+			// Sky light goes straight down without fading
+			int spread = face == FACE_NEG_Y && level == LIGHT_MAX ? LIGHT_MAX : level - 1;
+			uint8_t& light = World_light(world, neighbor);
+			if(light < spread) {
+				light = spread;
+				additions->push_back(neighbor);
+				if(touched) {
+					touched->push_back(neighbor);
+				}
+			}
+		}
+	}
+	additions->clear();
+}
+
+/**
+ * @brief Remove the light blocks gave their neighbors, breadth first
+ * @param world The world
+ * @param removals The blocks to remove the light of, emptied
+ * @param additions The blocks to spread the light of, the blocks lit from elsewhere met on the way being queued to spread their light back
+ * @param touched The blocks relit to add to
+*/
+void World_remove_light(World* world, std::vector<LightNode>* removals, std::vector<int>* additions, std::vector<int>* touched) {
+	coords3 min = {0, 0, 0};
+	coords3 max = {MAX_X_COORD - 1, MAX_Y_COORD - 1, MAX_Z_COORD - 1};
+	for(size_t head = 0; head < removals->size(); head++) {
+		LightNode node = (*removals)[head];
+		for(int face = 0; face < FACE_COUNT; face++) {
+			int neighbor = World_light_neighbor(node.index, (Face)face, min, max);
+			if(neighbor < 0) {
+				continue;
+			}
+			uint8_t& light = World_light(world, neighbor);
+			if(light == 0) {
+				continue;
+			}
+			bool fed = face == FACE_NEG_Y && node.level == LIGHT_MAX ? light == LIGHT_MAX : light < node.level;
+			if(fed) {
+				removals->push_back({neighbor, light});
+				light = 0;
+				touched->push_back(neighbor);
+			} else if(light >= node.level) {
+				additions->push_back(neighbor);
+			}
+		}
+	}
+	removals->clear();
+}
+
+/**
+ * @brief Remove and spread the light of the blocks queued in a world lighting, the areas far enough apart in parallel
+ * @param lighting The world lighting
+ * @param world The world
+ * @note The light of a block changes no further than LIGHT_MAX blocks sideways from it, so the chunk columns of the
+ * @note queued blocks are grouped with the ones close enough for their searches to meet, each group being a light region
+*/
+void WorldLighting_propagate(WorldLighting* lighting, World* world) {
+	// The group of each chunk column with queued blocks, as a union-find forest (-1 for the other ones)
+	std::array<int, X_CHUNK_COUNT * Z_CHUNK_COUNT> group;
+	group.fill(-1);
+	std::vector<int> columns;
+	auto column_of = [](int index) {
+		int x = index % MAX_X_COORD, z = index / (MAX_X_COORD * MAX_Y_COORD);
+		return x / X_CHUNK_SIZE + X_CHUNK_COUNT * (z / Z_CHUNK_SIZE);
+	};
+	auto add = [&](int index) {
+		int column = column_of(index);
+		if(group[column] < 0) {
+			group[column] = column;
+			columns.push_back(column);
+		}
+	};
+	for(const LightNode& node : lighting->removals) {
+		add(node.index);
+	}
+	for(int index : lighting->additions) {
+		add(index);
+	}
+	if(columns.empty()) {
+		return;
+	}
+	auto find = [&](int column) {
+		while(group[column] != column) {
+			group[column] = group[group[column]];
+			column = group[column];
+		}
+		return column;
+	};
+
+	// Two searches write up to LIGHT_MAX blocks away from their chunk columns and read one block further
+	int gap_x = (2 * (LIGHT_MAX + 1) + X_CHUNK_SIZE - 1) / X_CHUNK_SIZE;
+	int gap_z = (2 * (LIGHT_MAX + 1) + Z_CHUNK_SIZE - 1) / Z_CHUNK_SIZE;
+	for(size_t i = 0; i < columns.size(); i++) {
+		for(size_t j = i + 1; j < columns.size(); j++) {
+			int dx = columns[i] % X_CHUNK_COUNT - columns[j] % X_CHUNK_COUNT;
+			int dz = columns[i] / X_CHUNK_COUNT - columns[j] / X_CHUNK_COUNT;
+			if(std::abs(dx) <= gap_x && std::abs(dz) <= gap_z) {
+				group[find(columns[i])] = find(columns[j]);
+			}
+		}
+	}
+
+	std::vector<LightRegion> regions;
+	std::array<int, X_CHUNK_COUNT * Z_CHUNK_COUNT> region;
+	for(int column : columns) {
+		int root = find(column);
+		if(root == column) {
+			region[column] = regions.size();
+			regions.emplace_back();
+		}
+	}
+	for(const LightNode& node : lighting->removals) {
+		regions[region[find(column_of(node.index))]].removals.push_back(node);
+	}
+	for(int index : lighting->additions) {
+		regions[region[find(column_of(index))]].additions.push_back(index);
+	}
+	lighting->removals.clear();
+	lighting->additions.clear();
+
+	JobSystem_parallel_for(lighting->jobs, regions.size(), [&](int i) {
+		LightRegion& area = regions[i];
+		World_remove_light(world, &area.removals, &area.additions, &area.touched);
+		World_spread_light(world, &area.additions, {0, 0, 0}, {MAX_X_COORD - 1, MAX_Y_COORD - 1, MAX_Z_COORD - 1}, &area.touched);
+	}, 1);
+	for(const LightRegion& area : regions) {
+		for(int index : area.touched) {
+			WorldLighting_touch(lighting, index);
+		}
+	}
+}
+
+/**
+ * @brief Compute the light of a chunk column of a world from nothing, ignoring the other chunk columns
+ * @param world The world
+ * @param cx The x coordinate of the chunk column
+ * @param cz The z coordinate of the chunk column
+ * @param sky The masks of the blocks open to the sky to fill, indexed by World_chunk_index
+ * @note Only writes the light of the chunk column, so the chunk columns can be lit in parallel
+*/
+void World_light_column(World* world, int cx, int cz, std::vector<ChunkMask>* sky) {
+	// The sky light goes down each column of blocks until the first opaque block, one row of a chunk layer at a time
+	std::array<uint8_t, Z_CHUNK_SIZE> open;
+	open.fill(0xFF);
+	std::array<ChunkMask, Y_CHUNK_COUNT> dark;
+	for(int cy = Y_CHUNK_COUNT - 1; cy >= 0; cy--) {
+		Chunk* chunk = world->chunks[cz][cy][cx];
+		ChunkState* state = world->states[World_chunk_index(cx, cy, cz)];
+		ChunkMask& mask = (*sky)[World_chunk_index(cx, cy, cz)];
+		for(int z = 0; z < Z_CHUNK_SIZE; z++) {
+			uint64_t opacity = chunk->opacity[z];
+			uint64_t bits = 0;
+			for(int y = Y_CHUNK_SIZE - 1; y >= 0; y--) {
+				open[z] &= ~(uint8_t)(opacity >> (y * X_CHUNK_SIZE));
+				bits |= (uint64_t)open[z] << (y * X_CHUNK_SIZE);
+			}
+			mask[z] = bits;
+			dark[cy][z] = ~bits & ~opacity;
+			for(int y = 0; y < Y_CHUNK_SIZE; y++) {
+				for(int x = 0; x < X_CHUNK_SIZE; x++) {
+					state->light[z][y][x] = bits >> (x + y * X_CHUNK_SIZE) & 1 ? LIGHT_MAX : 0;
+				}
+			}
+		}
+	}
+
+	// Then spreads sideways from the blocks open to the sky next to a dark block that is not opaque
+	std::vector<int> additions;
+	for(int cy = 0; cy < Y_CHUNK_COUNT; cy++) {
+		const ChunkMask& mask = (*sky)[World_chunk_index(cx, cy, cz)];
+		for(int z = 0; z < Z_CHUNK_SIZE; z++) {
+			uint64_t d = dark[cy][z];
+			uint64_t near = (d << 1 & ~CHUNK_MASK_X_LOW) | (d >> 1 & ~CHUNK_MASK_X_HIGH) | d << X_CHUNK_SIZE | d >> X_CHUNK_SIZE;
+			near |= cy > 0 ? (dark[cy - 1][z] & CHUNK_MASK_Y_HIGH) >> (64 - X_CHUNK_SIZE) : 0;
+			near |= cy < Y_CHUNK_COUNT - 1 ? (dark[cy + 1][z] & CHUNK_MASK_Y_LOW) << (64 - X_CHUNK_SIZE) : 0;
+			near |= z > 0 ? dark[cy][z - 1] : 0;
+			near |= z < Z_CHUNK_SIZE - 1 ? dark[cy][z + 1] : 0;
+			uint64_t seeds = mask[z] & near;
+			while(seeds) {
+				int bit = __builtin_ctzll(seeds);
+				seeds &= seeds - 1;
+				int x = cx * X_CHUNK_SIZE + bit % X_CHUNK_SIZE;
+				int y = cy * Y_CHUNK_SIZE + bit / X_CHUNK_SIZE;
+				additions.push_back(x + MAX_X_COORD * (y + MAX_Y_COORD * (cz * Z_CHUNK_SIZE + z)));
+			}
+		}
+	}
+	coords3 min = {cx * X_CHUNK_SIZE, 0, cz * Z_CHUNK_SIZE};
+	coords3 max = {min.x + X_CHUNK_SIZE - 1, MAX_Y_COORD - 1, min.z + Z_CHUNK_SIZE - 1};
+	World_spread_light(world, &additions, min, max);
+}
+
+/**
+ * @brief Queue the brighter of two neighboring blocks of a world to spread its light to the other
+ * @param world The world
+ * @param a The index of a block
+ * @param b The index of its neighbor
+ * @param additions The blocks to spread the light of
+*/
+void World_light_across(World* world, int a, int b, std::vector<int>* additions) {
+	int la = World_light(world, a), lb = World_light(world, b);
+	if(la > lb + 1) {
+		additions->push_back(a);
+	} else if(lb > la + 1) {
+		additions->push_back(b);
+	}
+}
+
+/**
+ * @brief Compute the light of a whole world from nothing
+ * @param lighting The world lighting
+ * @param world The world
+ * @note The chunk columns are lit on their own in parallel, then the light is spread across their borders from the
+ * @note pairs of blocks that are not opaque where at least one is not open to the sky, the others being already even
+*/
+void WorldLighting_relight(WorldLighting* lighting, World* world) {
+	std::vector<ChunkMask> sky(WORLD_CHUNK_COUNT);
+	JobSystem_parallel_for(lighting->jobs, X_CHUNK_COUNT * Z_CHUNK_COUNT, [&](int column) {
+		World_light_column(world, column % X_CHUNK_COUNT, column / X_CHUNK_COUNT, &sky);
+	}, 1);
+
+	std::vector<int>& additions = lighting->additions;
+	for(int cz = 0; cz < Z_CHUNK_COUNT; cz++) {
+		for(int cy = 0; cy < Y_CHUNK_COUNT; cy++) {
+			for(int cx = 0; cx < X_CHUNK_COUNT; cx++) {
+				const Chunk* chunk = world->chunks[cz][cy][cx];
+				const ChunkMask& mask = sky[World_chunk_index(cx, cy, cz)];
+				int base = cx * X_CHUNK_SIZE + MAX_X_COORD * (cy * Y_CHUNK_SIZE + MAX_Y_COORD * cz * Z_CHUNK_SIZE);
+				if(cx > 0) {
+					// The x = 0 blocks of the chunk against the x = X_CHUNK_SIZE - 1 blocks of the one before it
+					const Chunk* before = world->chunks[cz][cy][cx - 1];
+					const ChunkMask& before_mask = sky[World_chunk_index(cx - 1, cy, cz)];
+					for(int z = 0; z < Z_CHUNK_SIZE; z++) {
+						uint64_t here = ~chunk->opacity[z] & CHUNK_MASK_X_LOW;
+						uint64_t there = ~before->opacity[z] >> (X_CHUNK_SIZE - 1) & CHUNK_MASK_X_LOW;
+						uint64_t dark = (~mask[z] & CHUNK_MASK_X_LOW) | (~before_mask[z] >> (X_CHUNK_SIZE - 1) & CHUNK_MASK_X_LOW);
+						uint64_t pairs = here & there & dark;
+						while(pairs) {
+							int y = __builtin_ctzll(pairs) / X_CHUNK_SIZE;
+							pairs &= pairs - 1;
+							int index = base + MAX_X_COORD * (y + MAX_Y_COORD * z);
+							World_light_across(world, index, index - 1, &additions);
+						}
+					}
+				}
+				if(cz > 0) {
+					// The z = 0 layer of the chunk against the z = Z_CHUNK_SIZE - 1 layer of the one before it
+					const Chunk* before = world->chunks[cz - 1][cy][cx];
+					const ChunkMask& before_mask = sky[World_chunk_index(cx, cy, cz - 1)];
+					uint64_t pairs = ~chunk->opacity[0] & ~before->opacity[Z_CHUNK_SIZE - 1] & (~mask[0] | ~before_mask[Z_CHUNK_SIZE - 1]);
+					while(pairs) {
+						int bit = __builtin_ctzll(pairs);
+						pairs &= pairs - 1;
+						int index = base + bit % X_CHUNK_SIZE + MAX_X_COORD * (bit / X_CHUNK_SIZE);
+						World_light_across(world, index, index - MAX_X_COORD * MAX_Y_COORD, &additions);
+					}
+				}
+			}
+		}
+	}
+	World_spread_light(world, &additions, {0, 0, 0}, {MAX_X_COORD - 1, MAX_Y_COORD - 1, MAX_Z_COORD - 1});
+}
+
+/**
+ * @brief Queue the blocks of a chunk column of a world along one of its sides for their light to be spread or removed
+ * @param lighting The world lighting
+ * @param world The world
+ * @param cx The x coordinate of the chunk column
+ * @param cz The z coordinate of the chunk column
+ * @param face The side of the chunk column, along x or z
+ * @param remove Whether to remove the light of the blocks rather than spread it
+ * @note The blocks open to the sky keep their light, which only comes from their own chunk column
+*/
+void WorldLighting_seam(WorldLighting* lighting, World* world, int cx, int cz, Face face, bool remove) {
+	coords3 normal = Face_normal(face);
+	for(int i = 0; i < X_CHUNK_SIZE; i++) {
+		int x = cx * X_CHUNK_SIZE + (normal.x == 0 ? i : (normal.x > 0 ? X_CHUNK_SIZE - 1 : 0));
+		int z = cz * Z_CHUNK_SIZE + (normal.z == 0 ? i : (normal.z > 0 ? Z_CHUNK_SIZE - 1 : 0));
+		for(int y = 0; y < MAX_Y_COORD; y++) {
+			int index = x + MAX_X_COORD * (y + MAX_Y_COORD * z);
+			if(World_light_blocked(world, index)) {
+				continue;
+			}
+			uint8_t& light = World_light(world, index);
+			if(!remove) {
+				lighting->additions.push_back(index);
+			} else if(light > 0 && light < LIGHT_MAX) {
+				lighting->removals.push_back({index, light});
+				light = 0;
+				WorldLighting_touch(lighting, index);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Bring the light of a world up to date with its blocks
+ * @param lighting The world lighting
+ * @param world The world
+ * @note Only called by the world thread, once per tick after the edits and the streaming
+ * @note The chunk columns that entered the window or had a chunk replaced are lit from nothing in parallel, then the
+ * @note light the others got across the seams with them (or with the chunk columns that left the window) is removed and
+ * @note spread back from both sides. The other blocks whose opacity changed since the last update get their light
+ * @note removed or spread incrementally, so the chunks that stay in the window keep their light when it moves, the
+ * @note light regions far enough apart being run in parallel.
+ * @note The relit chunks get a new light version and are marked dirty along with the neighbors whose faces their relit border lights.
+*/
+void WorldLighting_update(WorldLighting* lighting, World* world) {
+	ChunkTracker* tracker = lighting->tracker;
+	// The move of the window since the last update, a chunk at (cx, cz) being at (cx, cz) + shift before it
+	coords3 shift = {world->origin.x - tracker->origin.x, 0, world->origin.z - tracker->origin.z};
+	// The chunk columns to light from nothing, indexed by cx + X_CHUNK_COUNT * cz
+	std::array<bool, X_CHUNK_COUNT * Z_CHUNK_COUNT> fresh;
+	std::vector<int> columns;
+	for(int column = 0; column < X_CHUNK_COUNT * Z_CHUNK_COUNT; column++) {
+		int cx = column % X_CHUNK_COUNT;
+		int cz = column / X_CHUNK_COUNT;
+		fresh[column] = false;
+		for(int cy = 0; cy < Y_CHUNK_COUNT && !fresh[column]; cy++) {
+			fresh[column] = ChunkTracker_previous(tracker, world, cx, cy, cz) < 0;
+		}
+		if(fresh[column]) {
+			columns.push_back(column);
+		}
+	}
+
+	if(columns.size() == fresh.size()) {
+		ChunkMask all;
+		all.fill(~(uint64_t)0);
+		tracker->changed.fill(all);
+		WorldLighting_relight(lighting, world);
+	} else {
+		std::vector<ChunkMask> sky(WORLD_CHUNK_COUNT);
+		JobSystem_parallel_for(lighting->jobs, columns.size(), [&](int i) {
+			World_light_column(world, columns[i] % X_CHUNK_COUNT, columns[i] / X_CHUNK_COUNT, &sky);
+		}, 1);
+		const std::array<Face, 4> sides = {FACE_NEG_X, FACE_POS_X, FACE_NEG_Z, FACE_POS_Z};
+		for(int column = 0; column < X_CHUNK_COUNT * Z_CHUNK_COUNT; column++) {
+			int cx = column % X_CHUNK_COUNT;
+			int cz = column / X_CHUNK_COUNT;
+			for(int cy = 0; cy < Y_CHUNK_COUNT && fresh[column]; cy++) {
+				tracker->changed[World_chunk_index(cx, cy, cz)].fill(~(uint64_t)0);
+			}
+			for(Face face : sides) {
+				coords3 normal = Face_normal(face);
+				int nx = cx + normal.x, nz = cz + normal.z;
+				bool inside = nx >= 0 && nx < X_CHUNK_COUNT && nz >= 0 && nz < Z_CHUNK_COUNT;
+				bool was_inside = nx + shift.x >= 0 && nx + shift.x < X_CHUNK_COUNT && nz + shift.z >= 0 && nz + shift.z < Z_CHUNK_COUNT;
+				if(fresh[column]) {
+					if(inside) {
+						WorldLighting_seam(lighting, world, cx, cz, face, false);
+					}
+				} else if(inside ? fresh[nx + X_CHUNK_COUNT * nz] : was_inside) {
+					// The light from across the seam may come from a chunk column that is gone, so it is taken back first
+					WorldLighting_seam(lighting, world, cx, cz, face, true);
+					WorldLighting_seam(lighting, world, cx, cz, face, false);
+				}
+			}
+		}
+
+		for(int index = 0; index < WORLD_CHUNK_COUNT; index++) {
+			int cx = index % X_CHUNK_COUNT;
+			int cy = index / X_CHUNK_COUNT % Y_CHUNK_COUNT;
+			int cz = index / (X_CHUNK_COUNT * Y_CHUNK_COUNT);
+			if(fresh[cx + X_CHUNK_COUNT * cz]) {
+				continue;
+			}
+			const Chunk* chunk = World_get_chunk(world, cx, cy, cz);
+			ChunkMask flips = ChunkTracker_flipped(tracker, world, cx, cy, cz);
+			for(int z = 0; z < Z_CHUNK_SIZE; z++) {
+				uint64_t flipped = flips[z];
+				while(flipped) {
+					int bit = __builtin_ctzll(flipped);
+					flipped &= flipped - 1;
+					int x = cx * X_CHUNK_SIZE + bit % X_CHUNK_SIZE;
+					int y = cy * Y_CHUNK_SIZE + bit / X_CHUNK_SIZE;
+					int block = x + MAX_X_COORD * (y + MAX_Y_COORD * (cz * Z_CHUNK_SIZE + z));
+					uint8_t& light = World_light(world, block);
+					WorldLighting_touch(lighting, block);
+					if(chunk->opacity[z] >> bit & 1) {
+						// A new opaque block takes back the light it spread
+						if(light > 0) {
+							lighting->removals.push_back({block, light});
+							light = 0;
+						}
+					} else if(y == MAX_Y_COORD - 1) {
+						light = LIGHT_MAX;
+						lighting->additions.push_back(block);
+					} else {
+						// A block opened up lets the light of its neighbors in
+						for(int face = 0; face < FACE_COUNT; face++) {
+							int neighbor = World_light_neighbor(block, (Face)face, {0, 0, 0}, {MAX_X_COORD - 1, MAX_Y_COORD - 1, MAX_Z_COORD - 1});
+							if(neighbor >= 0) {
+								lighting->additions.push_back(neighbor);
+							}
+						}
+					}
+				}
+			}
+		}
+		WorldLighting_propagate(lighting, world);
+	}
+
+	lighting->relit = ChunkTracker_commit(tracker, world);
+}
+
+#endif
@@ -0,0 +1,708 @@
+#ifndef __AQUICE_SDL3_MESH_HPP__
+#define __AQUICE_SDL3_MESH_HPP__
+
+#include <vector>
+#include <array>
+#include <atomic>
+#include <algorithm>
+
+#include "SDL.hpp"
+#include "world.hpp"
+#include "order.hpp"
+#include "light.hpp"
+#include "ao.hpp"
+#include "shadow.hpp"
+#include "shade.hpp"
+#include "frame.hpp"
+#include "../utils/jobs.hpp"
+
+/**
+ * @brief The number of levels of detail of a chunk mesh
+ * @note The voxels of level n are made of 2^n blocks per side (1, 2, 4 and 8)
+*/
+#define MESH_LOD_COUNT 4
+/**
+ * @brief The minimum size in pixels of a voxel on screen before a coarser level of detail is used
+*/
+#define MESH_LOD_MIN_PIXELS 4
+
+/**
+ * @brief A visible face of a block
+*/
+typedef struct MeshFace {
+	/**
+	 * @brief The position of the block
+	*/
+	coords3 pos;
+	/**
+	 * @brief The face of the block
+	*/
+	Face face;
+	/**
+	 * @brief The block of the face, whose color the face is shaded from (air for the voxels of coarser levels of detail)
+	*/
+	Block block;
+	/**
+	 * @brief The brightness of the face, out of 255, from its orientation, the light it receives and the sun
+	*/
+	uint8_t shade;
+	/**
+	 * @brief The RGBA color of the face, the color of the block at the brightness of the face
+	*/
+	RGBA color;
+	/**
+	 * @brief The size of the block (greater than 1 for the voxels of coarser levels of detail)
+	*/
+	int size;
+	/**
+	 * @brief The ambient occlusion of the corners of the face, in the order of the corners (AO_MAX for all of them when unoccluded)
+	*/
+	std::array<uint8_t, 4> ao;
+	/**
+	 * @brief The corners of the face projected in 2D, as offsets from the origin
+	*/
+	std::array<coords, 4> corners;
+} MeshFace;
+
+/**
+ * @brief A projected outline segment of a mesh
+*/
+typedef struct MeshOutline {
+	/**
+	 * @brief The start of the segment, as an offset from the origin
+	*/
+	coords from;
+	/**
+	 * @brief The end of the segment, as an offset from the origin
+	*/
+	coords to;
+	/**
+	 * @brief The index of the face the segment is drawn with
+	*/
+	int face;
+} MeshOutline;
+
+/**
+ * @brief The mesh of a chunk at a level of detail
+*/
+typedef struct ChunkMeshLevel {
+	/**
+	 * @brief The faces of the chunk visible from the camera, from back to front
+	*/
+	std::vector<MeshFace> faces;
+	/**
+	 * @brief The outlines of the faces, each shared edge appearing once
+	*/
+	std::vector<MeshOutline> outlines;
+} ChunkMeshLevel;
+
+/**
+ * @brief The mesh of a chunk
+*/
+typedef struct ChunkMesh {
+	/**
+	 * @brief The levels of detail of the mesh, from the full resolution one
+	*/
+	std::array<ChunkMeshLevel, MESH_LOD_COUNT> levels;
+	/**
+	 * @brief The version of the chunk the mesh was built from
+	*/
+	uint32_t version;
+	/**
+	 * @brief The generation of the mesher the mesh was built in
+	*/
+	uint32_t generation;
+} ChunkMesh;
+
+/**
+ * @brief The meshes of a chunk, shared between the render thread and the workers
+*/
+typedef struct ChunkMeshSlot {
+	/**
+	 * @brief The mesh drawn by the render thread
+	 * @note Only the render thread reads and writes it
+	*/
+	ChunkMesh* current;
+	/**
+	 * @brief The last mesh published by a worker, not yet adopted by the render thread
+	*/
+	std::atomic<ChunkMesh*> pending;
+	/**
+	 * @brief Whether a worker is building a mesh for the chunk
+	*/
+	std::atomic<bool> building;
+	/**
+	 * @brief The last job sent to build a mesh for the chunk (null when none was sent)
+	 * @note Only the render thread reads and writes it
+	*/
+	JobHandle job;
+} ChunkMeshSlot;
+
+/**
+ * @brief The mesher of the chunks of a world
+*/
+typedef struct ChunkMesher {
+	/**
+	 * @brief The mesh slots, indexed by World_chunk_index
+	*/
+	std::array<ChunkMeshSlot, WORLD_CHUNK_COUNT> slots;
+	/**
+	 * @brief The number of meshes published since the last adoption
+	*/
+	std::atomic<int> ready;
+	/**
+	 * @brief The job system the meshes are built on
+	*/
+	JobSystem* jobs;
+	/**
+	 * @brief The indices of the slots whose current mesh has faces, the only ones drawn, from back to front
+	*/
+	std::vector<int> drawn;
+	/**
+	 * @brief The configuration the meshes are projected with
+	*/
+	SDL3_Config config;
+	/**
+	 * @brief The colors of the palette of the world at every brightness, which the faces are drawn with
+	*/
+	ShadeTable shades;
+	/**
+	 * @brief The 2D bounding boxes of the chunks, as offsets from the origin, indexed by World_chunk_index
+	*/
+	std::array<SDL_Rect, WORLD_CHUNK_COUNT> bounds;
+	/**
+	 * @brief The position of the world window the meshes are built for, in chunks
+	*/
+	coords3 origin;
+	/**
+	 * @brief The generation of the meshes, increased each time they are all dropped
+	 * @note Only the render thread reads and writes it, the meshes of an older generation are dropped when adopted
+	*/
+	uint32_t generation;
+} ChunkMesher;
+
+/**
+ * @brief A chunk meshing job, reading the chunk and its neighbors from a published frame
+*/
+typedef struct ChunkMeshJob {
+	/**
+	 * @brief The frame the chunk is meshed from, kept alive until the job is done
+	*/
+	WorldFrameRef frame;
+	/**
+	 * @brief The index of the chunk in the world
+	*/
+	int index;
+	/**
+	 * @brief The configuration to project the mesh with
+	*/
+	SDL3_Config config;
+	/**
+	 * @brief The generation of the mesher the job was sent in
+	*/
+	uint32_t generation;
+} ChunkMeshJob;
+
+/**
+ * @brief Check whether a face is turned towards the camera
+ * @param face The face
+ * @param cam_vec The vector of the camera
+ * @return Whether the face can be seen from the camera
+*/
+bool Face_faces_camera(Face face, coords3 cam_vec) {
+	coords3 normal = Face_normal(face);
+	return normal.x * cam_vec.x + normal.y * cam_vec.y + normal.z * cam_vec.z > 0;
+}
+
+/**
+ * @brief Get the corners of a face of a block
+ * @param pos The position of the block
+ * @param face The face
+ * @param size The size of the block
+ * @return The corners of the face, in loop order
+*/
+std::array<coords3, 4> Face_corners(coords3 pos, Face face, int size = 1) {
+	int d = face % 2 * size;
+	switch(face / 2) {
+		case 0:
+			return {{
+				{pos.x + d, pos.y, pos.z},
+				{pos.x + d, pos.y + size, pos.z},
+				{pos.x + d, pos.y + size, pos.z + size},
+				{pos.x + d, pos.y, pos.z + size}
+			}};
+		case 1:
+			return {{
+				{pos.x, pos.y + d, pos.z},
+				{pos.x + size, pos.y + d, pos.z},
+				{pos.x + size, pos.y + d, pos.z + size},
+				{pos.x, pos.y + d, pos.z + size}
+			}};
+		default:
+			return {{
+				{pos.x, pos.y, pos.z + d},
+				{pos.x + size, pos.y, pos.z + d},
+				{pos.x + size, pos.y + size, pos.z + d},
+				{pos.x, pos.y + size, pos.z + d}
+			}};
+	}
+}
+
+/**
+ * @brief Build the outlines of a mesh level from its projected faces
+ * @param level The mesh level
+ * @note An edge shared by several faces is only drawn with the last (nearest) one, the outlines keep the order of the faces
+*/
+void ChunkMeshLevel_build_outlines(ChunkMeshLevel* level) {
+	std::vector<MeshOutline> outlines;
+	for(int f = 0; f < (int)level->faces.size(); f++) {
+		MeshFace& face = level->faces[f];
+		for(int i = 0; i < 4; i++) {
+			coords from = face.corners[i];
+			coords to = face.corners[(i + 1) % 4];
+			if(to.x < from.x || (to.x == from.x && to.y < from.y)) {
+				std::swap(from, to);
+			}
+			outlines.push_back({from, to, f});
+		}
+	}
+
+	auto key = [&](int i) {
+		return std::array<int, 4>({outlines[i].from.x, outlines[i].from.y, outlines[i].to.x, outlines[i].to.y});
+	};
+	std::vector<int> indices(outlines.size());
+	for(int i = 0; i < (int)indices.size(); i++) {
+		indices[i] = i;
+	}
+	std::stable_sort(indices.begin(), indices.end(), [&](int a, int b) {
+		return key(a) < key(b);
+	});
+	std::vector<bool> shadowed(outlines.size(), false);
+	for(int i = 0; i + 1 < (int)indices.size(); i++) {
+		if(key(indices[i]) == key(indices[i + 1])) {
+			shadowed[indices[i]] = true;
+		}
+	}
+
+	level->outlines.clear();
+	for(int i = 0; i < (int)outlines.size(); i++) {
+		if(!shadowed[i]) {
+			level->outlines.push_back(outlines[i]);
+		}
+	}
+}
+
+/**
+ * @brief Downsample a chunk mask to a coarser grid
+ * @param mask The chunk mask
+ * @param size The size of the cells of the coarser grid
+ * @return The cells of the coarser grid (x + y * n + z * n * n with n the number of cells per side), set when any of their blocks is set
+*/
+std::vector<bool> ChunkMask_downsample(const ChunkMask& mask, int size) {
+	int n = X_CHUNK_SIZE / size;
+	std::vector<bool> cells(n * n * n, false);
+	for(int z = 0; z < Z_CHUNK_SIZE; z++) {
+		uint64_t bits = mask[z];
+		while(bits) {
+			int bit = __builtin_ctzll(bits);
+			bits &= bits - 1;
+			cells[bit % X_CHUNK_SIZE / size + n * (bit / X_CHUNK_SIZE / size + n * (z / size))] = true;
+		}
+	}
+	return cells;
+}
+
+/**
+ * @brief Build a coarser level of detail of the mesh of a chunk
+ * @param chunk The chunk
+ * @param state The shading of the chunk
+ * @param palette The palette of the blocks of the chunk
+ * @param nopacity The opacity masks of the neighbors of the chunk
+ * @param nlight The light of the neighbors of the chunk
+ * @param nshadow The shadow masks of the neighbors of the chunk
+ * @param origin The position of the first block of the chunk
+ * @param config The SDL3 configuration to project the mesh with
+ * @param lod The level of detail (greater than 0)
+ * @param level The mesh level to fill
+ * @note A voxel is solid (and opaque) when any of its blocks is, its color is the average of its solid blocks
+ * @note A face is lit by the block in front of the middle of the face
+*/
+void ChunkMesh_build_level(const Chunk* chunk, const ChunkState* state, const Palette* palette, const std::array<ChunkMask, FACE_COUNT>& nopacity, const std::array<ChunkLight, FACE_COUNT>& nlight, const std::array<ChunkMask, FACE_COUNT>& nshadow, coords3 origin, SDL3_Config* config, int lod, ChunkMeshLevel* level) {
+	int size = 1 << lod;
+	int n = X_CHUNK_SIZE / size;
+	auto solid = ChunkMask_downsample(chunk->occupancy, size);
+	auto opaque = ChunkMask_downsample(chunk->opacity, size);
+	std::array<std::vector<bool>, FACE_COUNT> nopaque;
+	for(int face = 0; face < FACE_COUNT; face++) {
+		nopaque[face] = ChunkMask_downsample(nopacity[face], size);
+	}
+
+	// Whether the voxel in front of a face hides it, looking into the neighbor chunk on the border
+	auto hidden = [&](int x, int y, int z, Face face) {
+		coords3 normal = Face_normal(face);
+		int nx = x + normal.x;
+		int ny = y + normal.y;
+		int nz = z + normal.z;
+		if(nx >= 0 && ny >= 0 && nz >= 0 && nx < n && ny < n && nz < n) {
+			return (bool)opaque[nx + n * (ny + n * nz)];
+		}
+		nx = (nx + n) % n;
+		ny = (ny + n) % n;
+		nz = (nz + n) % n;
+		return (bool)nopaque[face][nx + n * (ny + n * nz)];
+	};
+
+	std::vector<int> order(n * n * n);
+	PaintOrder_fill(config->cam_vec, {n, n, n}, order.data());
+	for(int cell : order) {
+		if(!solid[cell]) {
+			continue;
+		}
+		int x = cell % n;
+		int y = cell / n % n;
+		int z = cell / (n * n);
+
+		int r = 0, g = 0, b = 0, a = 0, count = 0;
+		for(int bz = z * size; bz < (z + 1) * size; bz++) {
+			for(int by = y * size; by < (y + 1) * size; by++) {
+				for(int bx = x * size; bx < (x + 1) * size; bx++) {
+					RGBA color = palette->colors[chunk->blocks[bz][by][bx].id];
+					if(Block_is_solid(chunk->blocks[bz][by][bx])) {
+						r += color.r;
+						g += color.g;
+						b += color.b;
+						a = std::max(a, color.a);
+						count++;
+					}
+				}
+			}
+		}
+		RGBA color = {r / count, g / count, b / count, a};
+
+		for(int face = 0; face < FACE_COUNT; face++) {
+			if(!Face_faces_camera((Face)face, config->cam_vec) || hidden(x, y, z, (Face)face)) {
+				continue;
+			}
+			coords3 normal = Face_normal((Face)face);
+			int lx = normal.x ? (normal.x > 0 ? (x + 1) * size : x * size - 1) : x * size + size / 2;
+			int ly = normal.y ? (normal.y > 0 ? (y + 1) * size : y * size - 1) : y * size + size / 2;
+			int lz = normal.z ? (normal.z > 0 ? (z + 1) * size : z * size - 1) : z * size + size / 2;
+			uint8_t light = ChunkState_light_at(state, nlight, lx, ly, lz);
+			uint8_t shade = Face_shade((Face)face, light, Face_faces_sun((Face)face, config->sun_vec) && !ChunkState_shadow_at(state, nshadow, lx, ly, lz));
+			MeshFace mface = {
+				{origin.x + x * size, origin.y + y * size, origin.z + z * size},
+				(Face)face,
+				Block{},
+				shade,
+				RGBA_scale(color, shade),
+				size,
+				{AO_MAX, AO_MAX, AO_MAX, AO_MAX},
+				{}
+			};
+			auto corners = Face_corners(mface.pos, mface.face, size);
+			for(int i = 0; i < 4; i++) {
+				mface.corners[i] = get_2d_offset(corners[i], config);
+			}
+			level->faces.push_back(mface);
+		}
+	}
+	ChunkMeshLevel_build_outlines(level);
+}
+
+/**
+ * @brief Build the mesh of a chunk
+ * @param chunk The chunk
+ * @param state The shading of the chunk
+ * @param palette The palette of the blocks of the chunk
+ * @param nopacity The opacity masks of the neighbors of the chunk
+ * @param nlight The light of the neighbors of the chunk
+ * @param nshadow The shadow masks of the neighbors of the chunk
+ * @param apron The opacity of the chunk and of the blocks of its neighbors around it
+ * @param origin The position of the first block of the chunk
+ * @param config The SDL3 configuration to project the mesh with
+ * @return The mesh pointer
+ * @note Only the exposed faces turned towards the camera are kept, in the back-to-front order of the camera
+ * @note The faces are shaded from their orientation, the light of the block in front of them and the sun if it reaches them, so drawing them costs nothing more
+ * @note The ambient occlusion of the corners of the faces is computed once here and only interpolated when drawing,
+ * @note the coarser levels of detail are left unoccluded
+ * @note Every level of detail is built
+*/
+ChunkMesh* ChunkMesh_build(const Chunk* chunk, const ChunkState* state, const Palette* palette, const std::array<ChunkMask, FACE_COUNT>& nopacity, const std::array<ChunkLight, FACE_COUNT>& nlight, const std::array<ChunkMask, FACE_COUNT>& nshadow, const ChunkApron& apron, coords3 origin, SDL3_Config* config) {
+	ChunkMesh* mesh = new ChunkMesh();
+	mesh->version = chunk->version;
+	if(Chunk_is_empty(chunk)) {
+		return mesh;
+	}
+
+	ChunkFaceMasks exposed;
+	Chunk_exposed_faces(chunk, nopacity, &exposed);
+
+	std::vector<Face> faces;
+	ChunkMask visible = {};
+	for(int face = 0; face < FACE_COUNT; face++) {
+		if(Face_faces_camera((Face)face, config->cam_vec)) {
+			faces.push_back((Face)face);
+			for(int z = 0; z < Z_CHUNK_SIZE; z++) {
+				visible[z] |= exposed[face][z];
+			}
+		}
+	}
+
+	auto opaque = [&apron](int x, int y, int z) { return ChunkApron_opaque(apron, x, y, z); };
+
+	// The faces of a single cube turned towards the camera never overlap, only the order of the blocks matters
+	for(int block : PaintOrder_get(config->cam_vec)->blocks) {
+		int x = block % X_CHUNK_SIZE;
+		int y = block / X_CHUNK_SIZE % Y_CHUNK_SIZE;
+		int z = block / (X_CHUNK_SIZE * Y_CHUNK_SIZE);
+		uint64_t bit = ChunkMask_bit(x, y);
+		if(!(visible[z] & bit)) {
+			continue;
+		}
+		for(Face face : faces) {
+			if(!(exposed[face][z] & bit)) {
+				continue;
+			}
+			coords3 normal = Face_normal(face);
+			uint8_t light = ChunkState_light_at(state, nlight, x + normal.x, y + normal.y, z + normal.z);
+			uint8_t shade = Face_shade(face, light, Face_faces_sun(face, config->sun_vec) && !ChunkState_shadow_at(state, nshadow, x + normal.x, y + normal.y, z + normal.z));
+			MeshFace mface = {
+				{origin.x + x, origin.y + y, origin.z + z},
+				face,
+				chunk->blocks[z][y][x],
+				shade,
+				RGBA_scale(palette->colors[chunk->blocks[z][y][x].id], shade),
+				1,
+				Face_ao({x, y, z}, face, opaque),
+				{}
+			};
+			auto corners = Face_corners(mface.pos, mface.face);
+			for(int i = 0; i < 4; i++) {
+				mface.corners[i] = get_2d_offset(corners[i], config);
+			}
+			mesh->levels[0].faces.push_back(mface);
+		}
+	}
+	ChunkMeshLevel_build_outlines(&mesh->levels[0]);
+
+	for(int lod = 1; lod < MESH_LOD_COUNT; lod++) {
+		ChunkMesh_build_level(chunk, state, palette, nopacity, nlight, nshadow, origin, config, lod, &mesh->levels[lod]);
+	}
+	return mesh;
+}
+
+/**
+ * @brief Compute the 2D bounding boxes of the chunks
+ * @param mesher The chunk mesher
+ * @note The boxes are offsets from the origin so they stay valid when the origin moves
+*/
+void ChunkMesher_compute_bounds(ChunkMesher* mesher) {
+	SDL3_Config config = mesher->config;
+	config.origin = {0, 0};
+	for(int cz = 0; cz < Z_CHUNK_COUNT; cz++) {
+		for(int cy = 0; cy < Y_CHUNK_COUNT; cy++) {
+			for(int cx = 0; cx < X_CHUNK_COUNT; cx++) {
+				mesher->bounds[World_chunk_index(cx, cy, cz)] = get_2d_bounds(
+					{cx * X_CHUNK_SIZE, cy * Y_CHUNK_SIZE, cz * Z_CHUNK_SIZE},
+					{(cx + 1) * X_CHUNK_SIZE, (cy + 1) * Y_CHUNK_SIZE, (cz + 1) * Z_CHUNK_SIZE},
+					&config
+				);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Create a new chunk mesher
+ * @param jobs The job system to build the meshes on
+ * @param config The SDL3 configuration
+ * @return The chunk mesher pointer
+*/
+ChunkMesher* ChunkMesher_new(JobSystem* jobs, SDL3_Config* config) {
+	ChunkMesher* mesher = new ChunkMesher();
+	for(auto& slot : mesher->slots) {
+		slot.current = nullptr;
+		slot.pending.store(nullptr);
+		slot.building.store(false);
+	}
+	mesher->ready.store(0);
+	mesher->jobs = jobs;
+	mesher->config = *config;
+	mesher->shades = ShadeTable_new();
+	mesher->origin = {0, 0, 0};
+	mesher->generation = 0;
+	ChunkMesher_compute_bounds(mesher);
+	return mesher;
+}
+
+/**
+ * @brief Free a chunk mesher and its meshes
+ * @param mesher The chunk mesher pointer
+ * @note Waits for the meshes being built
+*/
+void ChunkMesher_free(ChunkMesher* mesher) {
+	for(auto& slot : mesher->slots) {
+		JobSystem_wait(mesher->jobs, slot.job);
+		delete slot.current;
+		delete slot.pending.load();
+	}
+	delete mesher;
+}
+
+/**
+ * @brief Run a chunk meshing job and publish its mesh
+ * @param mesher The chunk mesher
+ * @param job The job pointer, freed by this function
+ * @note Runs on a worker thread, the mesh is published without locking
+*/
+void ChunkMesher_run_job(ChunkMesher* mesher, ChunkMeshJob* job) {
+	World* world = &job->frame->world;
+	int cx = job->index % X_CHUNK_COUNT;
+	int cy = job->index / X_CHUNK_COUNT % Y_CHUNK_COUNT;
+	int cz = job->index / (X_CHUNK_COUNT * Y_CHUNK_COUNT);
+	auto states = World_state_neighbors(world, cx, cy, cz);
+	ChunkMesh* mesh = ChunkMesh_build(
+		World_get_chunk(world, cx, cy, cz),
+		World_get_state(world, cx, cy, cz),
+		&world->palette,
+		Chunk_neighbors_opacity(World_chunk_neighbors(world, cx, cy, cz)),
+		ChunkState_neighbors_light(states),
+		ChunkState_neighbors_shadow(states),
+		World_chunk_apron(world, cx, cy, cz),
+		{cx * X_CHUNK_SIZE, cy * Y_CHUNK_SIZE, cz * Z_CHUNK_SIZE},
+		&job->config
+	);
+	mesh->generation = job->generation;
+	ChunkMeshSlot& slot = mesher->slots[job->index];
+
+	// A mesh still pending was never seen by the render thread
+	delete slot.pending.exchange(mesh, std::memory_order_acq_rel);
+	mesher->ready.fetch_add(1, std::memory_order_release);
+	slot.building.store(false, std::memory_order_release);
+	delete job;
+}
+
+/**
+ * @brief Drop every mesh of a chunk mesher, including the ones still being built
+ * @param mesher The chunk mesher
+ * @note Must be called by the render thread, nothing is drawn until the chunks are meshed again
+*/
+void ChunkMesher_clear(ChunkMesher* mesher) {
+	mesher->generation++;
+	for(auto& slot : mesher->slots) {
+		delete slot.current;
+		slot.current = nullptr;
+		delete slot.pending.exchange(nullptr, std::memory_order_acquire);
+	}
+	mesher->drawn.clear();
+}
+
+/**
+ * @brief Send the dirty chunks of a world to the workers
+ * @param mesher The chunk mesher
+ * @param world The world, whose dirty chunks are sent
+ * @param frame The frame of the world published since its last edit, which the workers mesh the chunks from
+ * @note Nothing is copied, the world can be edited while the workers read the frame
+ * @note A chunk already being meshed stays dirty until its current mesh is published
+ * @note The shade table follows the palette first, so it holds the colors of every mesh published
+ * @note When the world window moved, the meshes of the chunks it held before are dropped
+*/
+void ChunkMesher_dispatch(ChunkMesher* mesher, World* world, const WorldFrameRef& frame) {
+	ShadeTable_update(&mesher->shades, &frame->world.palette);
+	coords3 origin = frame->world.origin;
+	if(origin.x != mesher->origin.x || origin.y != mesher->origin.y || origin.z != mesher->origin.z) {
+		mesher->origin = origin;
+		ChunkMesher_clear(mesher);
+	}
+	std::vector<int> waiting;
+	for(int index : world->dirty) {
+		ChunkMeshSlot& slot = mesher->slots[index];
+		if(slot.building.load(std::memory_order_acquire)) {
+			waiting.push_back(index);
+			continue;
+		}
+
+		world->marked[index] = false;
+		slot.building.store(true, std::memory_order_relaxed);
+
+		ChunkMeshJob* job = new ChunkMeshJob{
+			frame,
+			index,
+			mesher->config,
+			mesher->generation
+		};
+		slot.job = JobSystem_submit(mesher->jobs, [mesher, job] { ChunkMesher_run_job(mesher, job); });
+	}
+	world->dirty = waiting;
+}
+
+/**
+ * @brief Adopt the meshes published by the workers
+ * @param mesher The chunk mesher
+ * @note Must be called by the render thread, the previous meshes are drawn until then
+*/
+void ChunkMesher_adopt(ChunkMesher* mesher) {
+	if(mesher->ready.exchange(0, std::memory_order_acquire) == 0) {
+		return;
+	}
+	mesher->drawn.clear();
+	for(int index : PaintOrder_get(mesher->config.cam_vec)->chunks) {
+		ChunkMeshSlot& slot = mesher->slots[index];
+		ChunkMesh* mesh = slot.pending.exchange(nullptr, std::memory_order_acquire);
+		if(mesh && mesh->generation != mesher->generation) {
+			delete mesh;
+		} else if(mesh) {
+			delete slot.current;
+			slot.current = mesh;
+		}
+		if(slot.current && !slot.current->levels[0].faces.empty()) {
+			mesher->drawn.push_back(index);
+		}
+	}
+}
+
+/**
+ * @brief Follow the changes of the SDL3 configuration
+ * @param mesher The chunk mesher
+ * @param world The world
+ * @param config The SDL3 configuration
+ * @note Moving the origin keeps the meshes, changing the size, the camera vector or the sun vector marks every chunk dirty, the next dispatch rebuilding them
+ * @note Recentering the world window also moves the origin, its meshes are dropped by the next dispatch
+*/
+void ChunkMesher_set_config(ChunkMesher* mesher, World* world, SDL3_Config* config) {
+	bool reproject = config->ref_size != mesher->config.ref_size
+		|| config->cam_vec.x != mesher->config.cam_vec.x
+		|| config->cam_vec.y != mesher->config.cam_vec.y
+		|| config->cam_vec.z != mesher->config.cam_vec.z;
+	bool reshade = config->sun_vec.x != mesher->config.sun_vec.x
+		|| config->sun_vec.y != mesher->config.sun_vec.y
+		|| config->sun_vec.z != mesher->config.sun_vec.z;
+	mesher->config = *config;
+	if(reproject) {
+		ChunkMesher_compute_bounds(mesher);
+	}
+	if(reproject || reshade) {
+		for(int cz = 0; cz < Z_CHUNK_COUNT; cz++) {
+			for(int cy = 0; cy < Y_CHUNK_COUNT; cy++) {
+				for(int cx = 0; cx < X_CHUNK_COUNT; cx++) {
+					World_mark_dirty(world, cx, cy, cz);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief Select the level of detail to draw the chunk meshes with
+ * @param block_pixels The size in pixels of a block on screen
+ * @return The coarsest level of detail whose voxels are at least MESH_LOD_MIN_PIXELS wide on screen, or the full resolution
+*/
+int ChunkMesh_select_lod(double block_pixels) {
+	int lod = 0;
+	while(lod < MESH_LOD_COUNT - 1 && block_pixels * (1 << lod) < MESH_LOD_MIN_PIXELS) {
+		lod++;
+	}
+	return lod;
+}
+
+#endif
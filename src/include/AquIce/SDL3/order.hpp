@@ -0,0 +1,107 @@
+#ifndef __AQUICE_SDL3_ORDER_HPP__
+#define __AQUICE_SDL3_ORDER_HPP__
+
+#include <array>
+#include <vector>
+
+#include "SDL.hpp"
+#include "world.hpp"
+
+/**
+ * @brief The number of blocks in a chunk
+*/
+#define CHUNK_BLOCK_COUNT (X_CHUNK_SIZE * Y_CHUNK_SIZE * Z_CHUNK_SIZE)
+
+/**
+ * @brief The back-to-front drawing order of the chunks and blocks for a camera orientation
+ * @note In isometric projection a cube can only hide cubes with a smaller depth (dot product with the camera vector),
+ * @note and cubes with the same depth never overlap on screen, so drawing by increasing depth needs no sorting.
+ * @note The same holds for chunks, which are cubes on a coarser grid.
+*/
+typedef struct PaintOrder {
+	/**
+	 * @brief The vector of the camera the order was built for
+	*/
+	coords3 cam_vec;
+	/**
+	 * @brief The chunk indices (World_chunk_index) from back to front
+	*/
+	std::array<int, WORLD_CHUNK_COUNT> chunks;
+	/**
+	 * @brief The block indices in a chunk (x + y * X_CHUNK_SIZE + z * X_CHUNK_SIZE * Y_CHUNK_SIZE) from back to front
+	*/
+	std::array<int, CHUNK_BLOCK_COUNT> blocks;
+} PaintOrder;
+
+/**
+ * @brief Order the cells of a grid by increasing depth
+ * @param cam_vec The vector of the camera
+ * @param size The size of the grid
+ * @param order The cell indices (x + y * size.x + z * size.x * size.y) to fill, from back to front
+ * @note A counting sort on the depth diagonals, linear in the number of cells
+*/
+void PaintOrder_fill(coords3 cam_vec, coords3 size, int* order) {
+	int sx = cam_vec.x < 0 ? -1 : 1;
+	int sy = cam_vec.y < 0 ? -1 : 1;
+	int sz = cam_vec.z < 0 ? -1 : 1;
+	// Shift the depths so the farthest cell is at 0
+	int min_depth = (sx < 0 ? sx * (size.x - 1) : 0) + (sy < 0 ? sy * (size.y - 1) : 0) + (sz < 0 ? sz * (size.z - 1) : 0);
+	auto depth = [&](int x, int y, int z) {
+		return sx * x + sy * y + sz * z - min_depth;
+	};
+
+	std::vector<int> starts(size.x + size.y + size.z, 0);
+	for(int z = 0; z < size.z; z++) {
+		for(int y = 0; y < size.y; y++) {
+			for(int x = 0; x < size.x; x++) {
+				starts[depth(x, y, z) + 1]++;
+			}
+		}
+	}
+	for(int d = 1; d < (int)starts.size(); d++) {
+		starts[d] += starts[d - 1];
+	}
+	for(int z = 0; z < size.z; z++) {
+		for(int y = 0; y < size.y; y++) {
+			for(int x = 0; x < size.x; x++) {
+				order[starts[depth(x, y, z)]++] = x + size.x * (y + size.y * z);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Build the drawing order for a camera orientation
+ * @param cam_vec The vector of the camera
+ * @return The drawing order
+*/
+PaintOrder PaintOrder_new(coords3 cam_vec) {
+	PaintOrder order;
+	order.cam_vec = cam_vec;
+	PaintOrder_fill(cam_vec, {X_CHUNK_COUNT, Y_CHUNK_COUNT, Z_CHUNK_COUNT}, order.chunks.data());
+	PaintOrder_fill(cam_vec, {X_CHUNK_SIZE, Y_CHUNK_SIZE, Z_CHUNK_SIZE}, order.blocks.data());
+	return order;
+}
+
+/**
+ * @brief Get the drawing order for the orientation of a camera vector
+ * @param cam_vec The vector of the camera
+ * @return The drawing order, shared and never modified
+ * @note The orders of the 8 orientations are all built on the first call
+*/
+const PaintOrder* PaintOrder_get(coords3 cam_vec) {
+	static const std::vector<PaintOrder> orders = [] {
+		std::vector<PaintOrder> orders;
+		for(int orientation = 0; orientation < 8; orientation++) {
+			orders.push_back(PaintOrder_new({
+				orientation & 1 ? -1 : 1,
+				orientation & 2 ? -1 : 1,
+				orientation & 4 ? -1 : 1
+			}));
+		}
+		return orders;
+	}();
+	return &orders[(cam_vec.x < 0 ? 1 : 0) | (cam_vec.y < 0 ? 2 : 0) | (cam_vec.z < 0 ? 4 : 0)];
+}
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef __AQUICE_SDL3_PICK_HPP__
+#define __AQUICE_SDL3_PICK_HPP__
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+
+#include "SDL.hpp"
+#include "world.hpp"
+#include "../SDL2/framebuffer.hpp"
+
+/**
+ * @brief The ID of the pixels no face is drawn on
+*/
+#define PICK_NONE 0
+
+/**
+ * @brief A picking buffer, holding the ID of the block face drawn on each pixel of a framebuffer
+*/
+typedef struct PickBuffer {
+	/**
+	 * @brief The width of the picking buffer
+	*/
+	int width;
+	/**
+	 * @brief The height of the picking buffer
+	*/
+	int height;
+	/**
+	 * @brief The IDs of the pixels, row by row (PICK_NONE where nothing is drawn)
+	*/
+	std::vector<uint32_t> ids;
+} PickBuffer;
+
+/**
+ * @brief Create a new picking buffer
+ * @param width The width of the picking buffer
+ * @param height The height of the picking buffer
+ * @return The picking buffer, with nothing drawn on it
+*/
+PickBuffer PickBuffer_new(int width, int height) {
+	return {
+		width,
+		height,
+		std::vector<uint32_t>(width * height, PICK_NONE)
+	};
+}
+
+/**
+ * @brief Get the ID of a face of a block
+ * @param pos The position of the block
+ * @param face The face of the block
+ * @return The ID
+*/
+uint32_t Pick_encode(coords3 pos, Face face) {
+	return 1 + face + FACE_COUNT * (pos.x + MAX_X_COORD * (pos.y + MAX_Y_COORD * pos.z));
+}
+
+/**
+ * @brief Clear a picking buffer so nothing is drawn on it
+ * @param pick The picking buffer
+ * @param rect The part of the picking buffer to clear (nullptr for all of it)
+*/
+void PickBuffer_clear(PickBuffer* pick, SDL_Rect* rect = nullptr) {
+	int x0 = rect ? std::max(rect->x, 0) : 0;
+	int y0 = rect ? std::max(rect->y, 0) : 0;
+	int x1 = rect ? std::min(rect->x + rect->w, pick->width) : pick->width;
+	int y1 = rect ? std::min(rect->y + rect->h, pick->height) : pick->height;
+	for(int y = y0; y < y1; y++) {
+		std::fill(pick->ids.begin() + y * pick->width + x0, pick->ids.begin() + y * pick->width + std::max(x1, x0), PICK_NONE);
+	}
+}
+
+/**
+ * @brief Draw the ID of a face on a pixel of a picking buffer
+ * @param pick The picking buffer
+ * @param x The x coordinate of the pixel
+ * @param y The y coordinate of the pixel
+ * @param id The ID of the face
+*/
+void PickBuffer_draw_pixel(PickBuffer* pick, int x, int y, uint32_t id) {
+	pick->ids[y * pick->width + x] = id;
+}
+
+/**
+ * @brief Fill a convex quad on a picking buffer
+ * @param pick The picking buffer
+ * @param corners The corners of the quad, in loop order
+ * @param id The ID of the face
+ * @param clip The part of the picking buffer to draw in
+ * @note The pixels filled are the ones Framebuffer_fill_quad fills
+*/
+void PickBuffer_fill_quad(PickBuffer* pick, std::array<coords, 4> corners, uint32_t id, SDL_Rect clip) {
+	uint32_t* ids = pick->ids.data();
+	int width = pick->width;
+	scan_quad_spans(corners, clip, [&](int y, int begin, int end) {
+		std::fill(ids + y * width + begin, ids + y * width + end, id);
+	});
+}
+
+/**
+ * @brief Get the block face drawn on a pixel of a picking buffer
+ * @param pick The picking buffer
+ * @param x The x coordinate of the pixel
+ * @param y The y coordinate of the pixel
+ * @param pos The position of the block to fill
+ * @param face The face of the block to fill
+ * @return Whether a face is drawn on the pixel
+*/
+bool PickBuffer_get(PickBuffer* pick, int x, int y, coords3* pos, Face* face) {
+	if(x < 0 || y < 0 || x >= pick->width || y >= pick->height) {
+		return false;
+	}
+	uint32_t id = pick->ids[y * pick->width + x];
+	if(id == PICK_NONE) {
+		return false;
+	}
+	id--;
+	*face = (Face)(id % FACE_COUNT);
+	id /= FACE_COUNT;
+	pos->x = id % MAX_X_COORD;
+	pos->y = id / MAX_X_COORD % MAX_Y_COORD;
+	pos->z = id / (MAX_X_COORD * MAX_Y_COORD);
+	return true;
+}
+
+#endif
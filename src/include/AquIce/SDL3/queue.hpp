@@ -0,0 +1,310 @@
+#ifndef __AQUICE_SDL3_QUEUE_HPP__
+#define __AQUICE_SDL3_QUEUE_HPP__
+
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "SDL.hpp"
+#include "world.hpp"
+#include "edit.hpp"
+#include "journal.hpp"
+
+/**
+ * @brief The default number of commands an edit queue holds
+*/
+#define EDIT_QUEUE_CAPACITY 4096
+
+/**
+ * @brief The kinds of edit commands
+*/
+typedef enum EditCommandType {
+	EDIT_SET_BLOCK,
+	EDIT_FILL_BOX,
+	EDIT_MOVE_CAMERA,
+	EDIT_UNDO,
+	EDIT_REDO
+} EditCommandType;
+
+/**
+ * @brief A command sent to the thread updating the world
+*/
+typedef struct EditCommand {
+	/**
+	 * @brief The kind of the command
+	*/
+	EditCommandType type;
+	/**
+	 * @brief The block to set, or a corner of the box to fill, in the unbounded world
+	*/
+	coords3 from;
+	/**
+	 * @brief The opposite corner of the box to fill, in the unbounded world
+	*/
+	coords3 to;
+	/**
+	 * @brief The block to write
+	*/
+	Block block;
+	/**
+	 * @brief The offset to move the origin of the camera by
+	*/
+	coords offset;
+	/**
+	 * @brief The new vector of the camera (all zero to keep it)
+	*/
+	coords3 cam_vec;
+} EditCommand;
+
+/**
+ * @brief A slot of an edit queue
+*/
+typedef struct EditQueueSlot {
+	/**
+	 * @brief The position in the queue the slot is ready for: to be written when equal to it, to be read when one more
+	*/
+	std::atomic<size_t> sequence;
+	/**
+	 * @brief The command
+	*/
+	EditCommand command;
+} EditQueueSlot;
+
+/**
+ * @brief A bounded lock-free queue of edit commands, written by any number of threads and read by the world thread
+ * @note The slots carry sequence numbers so producers claim them with a single compare and swap
+*/
+typedef struct EditQueue {
+	/**
+	 * @brief The slots, a power of two of them
+	*/
+	std::vector<EditQueueSlot> slots;
+	/**
+	 * @brief The mask of a position to its slot
+	*/
+	size_t mask;
+	/**
+	 * @brief The position the next command is written to
+	*/
+	alignas(64) std::atomic<size_t> tail;
+	/**
+	 * @brief The position the next command is read from (only used by the world thread)
+	*/
+	alignas(64) size_t head;
+} EditQueue;
+
+/**
+ * @brief Create a new edit queue
+ * @param capacity The number of commands the queue holds, rounded up to a power of two
+ * @return The edit queue pointer
+*/
+EditQueue* EditQueue_new(size_t capacity = EDIT_QUEUE_CAPACITY) {
+	size_t size = 2;
+	while(size < capacity) {
+		size *= 2;
+	}
+	EditQueue* queue = new EditQueue();
+	queue->slots = std::vector<EditQueueSlot>(size);
+	for(size_t i = 0; i < size; i++) {
+		queue->slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	queue->mask = size - 1;
+	queue->tail.store(0, std::memory_order_relaxed);
+	queue->head = 0;
+	return queue;
+}
+
+/**
+ * @brief Free an edit queue
+ * @param queue The edit queue pointer
+*/
+void EditQueue_free(EditQueue* queue) {
+	delete queue;
+}
+
+/**
+ * @brief Send a command to the world thread
+ * @param queue The edit queue
+ * @param command The command
+ * @return Whether the command was queued, false if the queue is full
+ * @note Lock-free, can be called from any thread
+*/
+bool EditQueue_push(EditQueue* queue, const EditCommand& command) {
+	size_t position = queue->tail.load(std::memory_order_relaxed);
+	while(true) {
+		EditQueueSlot& slot = queue->slots[position & queue->mask];
+		size_t sequence = slot.sequence.load(std::memory_order_acquire);
+		intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+		if(difference == 0) {
+			if(queue->tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+				slot.command = command;
+				slot.sequence.store(position + 1, std::memory_order_release);
+				return true;
+			}
+		} else if(difference < 0) {
+			// The slot still holds a command from a lap ago
+			return false;
+		} else {
+			position = queue->tail.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+/**
+ * @brief Take the oldest command of an edit queue
+ * @param queue The edit queue
+ * @param command The command to fill
+ * @return Whether there was a command
+ * @note Only called by the world thread
+*/
+bool EditQueue_pop(EditQueue* queue, EditCommand* command) {
+	EditQueueSlot& slot = queue->slots[queue->head & queue->mask];
+	if(slot.sequence.load(std::memory_order_acquire) != queue->head + 1) {
+		return false;
+	}
+	*command = slot.command;
+	slot.sequence.store(queue->head + queue->mask + 1, std::memory_order_release);
+	queue->head++;
+	return true;
+}
+
+/**
+ * @brief Send a command setting a block
+ * @param queue The edit queue
+ * @param pos The position of the block in the unbounded world
+ * @param block The block
+ * @return Whether the command was queued
+ * @note The position stays valid when a chunk streamer moves the world before the command is applied
+*/
+bool EditQueue_set_block(EditQueue* queue, coords3 pos, Block block) {
+	return EditQueue_push(queue, {EDIT_SET_BLOCK, pos, pos, block, {0, 0}, {0, 0, 0}});
+}
+
+/**
+ * @brief Send a command filling a box
+ * @param queue The edit queue
+ * @param from A corner of the box in the unbounded world
+ * @param to The opposite corner of the box in the unbounded world
+ * @param block The block
+ * @return Whether the command was queued
+*/
+bool EditQueue_fill_box(EditQueue* queue, coords3 from, coords3 to, Block block) {
+	return EditQueue_push(queue, {EDIT_FILL_BOX, from, to, block, {0, 0}, {0, 0, 0}});
+}
+
+/**
+ * @brief Send a command moving the camera
+ * @param queue The edit queue
+ * @param offset The offset to move the origin of the camera by
+ * @param cam_vec The new vector of the camera (all zero to keep it)
+ * @return Whether the command was queued
+*/
+bool EditQueue_move_camera(EditQueue* queue, coords offset, coords3 cam_vec = {0, 0, 0}) {
+	return EditQueue_push(queue, {EDIT_MOVE_CAMERA, {0, 0, 0}, {0, 0, 0}, Block{}, offset, cam_vec});
+}
+
+/**
+ * @brief Send a command undoing the last edit recorded in the journal of the world
+ * @param queue The edit queue
+ * @return Whether the command was queued
+*/
+bool EditQueue_undo(EditQueue* queue) {
+	return EditQueue_push(queue, {EDIT_UNDO, {0, 0, 0}, {0, 0, 0}, Block{}, {0, 0}, {0, 0, 0}});
+}
+
+/**
+ * @brief Send a command redoing the last edit undone
+ * @param queue The edit queue
+ * @return Whether the command was queued
+*/
+bool EditQueue_redo(EditQueue* queue) {
+	return EditQueue_push(queue, {EDIT_REDO, {0, 0, 0}, {0, 0, 0}, Block{}, {0, 0}, {0, 0, 0}});
+}
+
+/**
+ * @brief Write the blocks set by the commands of a batch and finish its bulk edit
+ * @param edit The bulk edit of the batch
+ * @param blocks The last block set on each voxel, by voxel index, emptied
+*/
+void EditQueue_commit(WorldEdit* edit, std::unordered_map<int, Block>* blocks) {
+	for(auto& entry : *blocks) {
+		int index = entry.first;
+		WorldEdit_set_block(edit, index % MAX_X_COORD, index / MAX_X_COORD % MAX_Y_COORD, index / (MAX_X_COORD * MAX_Y_COORD), entry.second);
+	}
+	blocks->clear();
+	WorldEdit_commit(edit);
+}
+
+/**
+ * @brief Apply the commands of an edit queue as one batch
+ * @param queue The edit queue
+ * @param world The world
+ * @param config The SDL3 configuration the camera commands change
+ * @param limit The largest number of commands to apply (0 for all of them)
+ * @return The number of commands applied
+ * @note Only called by the world thread, once per tick
+ * @note Only the last block set on a voxel is written, and blocks set before a box covering them are dropped,
+ * @note then every chunk written to gets its masks updated and is marked dirty once
+ * @note An undo or redo command commits the edits before it, so the batch is recorded in the journal as one entry per undo point
+ * @note The positions of the commands are moved into the window of the world, the blocks outside of it being dropped
+*/
+int EditQueue_apply(EditQueue* queue, World* world, SDL3_Config* config, int limit = 0) {
+	EditCommand command;
+	if(!EditQueue_pop(queue, &command)) {
+		return 0;
+	}
+	WorldEdit edit = WorldEdit_new(world);
+	// The last block set on each voxel, by voxel index
+	std::unordered_map<int, Block> blocks;
+
+	int applied = 0;
+	do {
+		applied++;
+		switch(command.type) {
+			case EDIT_SET_BLOCK: {
+				coords3 pos = World_window_pos(world, command.from);
+				if(!World_contains(pos.x, pos.y, pos.z)) {
+					break;
+				}
+				int index = pos.x + MAX_X_COORD * (pos.y + MAX_Y_COORD * pos.z);
+				blocks[index] = command.block;
+				break;
+			}
+			case EDIT_FILL_BOX: {
+				coords3 min, max;
+				if(!World_clip_box(World_window_pos(world, command.from), World_window_pos(world, command.to), &min, &max)) {
+					break;
+				}
+				// The blocks set inside the box are overwritten, the others do not overlap it and can be written after it
+				for(auto it = blocks.begin(); it != blocks.end();) {
+					int x = it->first % MAX_X_COORD, y = it->first / MAX_X_COORD % MAX_Y_COORD, z = it->first / (MAX_X_COORD * MAX_Y_COORD);
+					bool inside = x >= min.x && x <= max.x && y >= min.y && y <= max.y && z >= min.z && z <= max.z;
+					it = inside ? blocks.erase(it) : std::next(it);
+				}
+				WorldEdit_fill_box(&edit, min, max, command.block);
+				break;
+			}
+			case EDIT_MOVE_CAMERA:
+				config->origin.x += command.offset.x;
+				config->origin.y += command.offset.y;
+				if(command.cam_vec.x || command.cam_vec.y || command.cam_vec.z) {
+					config->cam_vec = command.cam_vec;
+				}
+				break;
+			case EDIT_UNDO:
+				EditQueue_commit(&edit, &blocks);
+				World_undo(world);
+				break;
+			case EDIT_REDO:
+				EditQueue_commit(&edit, &blocks);
+				World_redo(world);
+				break;
+		}
+	} while((limit <= 0 || applied < limit) && EditQueue_pop(queue, &command));
+	EditQueue_commit(&edit, &blocks);
+	return applied;
+}
+
+#endif
@@ -0,0 +1,391 @@
+#ifndef __AQUICE_SDL3_RASTER_HPP__
+#define __AQUICE_SDL3_RASTER_HPP__
+
+#include <vector>
+#include <algorithm>
+
+#include "SDL.hpp"
+#include "mesh.hpp"
+#include "pick.hpp"
+#include "../SDL2/framebuffer.hpp"
+#include "../utils/jobs.hpp"
+
+/**
+ * @brief The color of the outlines drawn over the faces
+*/
+#define RASTER_OUTLINE_COLOR RGBA{0, 0, 0, 255}
+/**
+ * @brief The size of the square screen tiles rasterized by a worker at once
+*/
+#define RASTER_TILE_SIZE 64
+
+/**
+ * @brief A face binned in a screen tile, with its outlines
+*/
+typedef struct RasterRef {
+	/**
+	 * @brief The index of the chunk of the face
+	*/
+	int chunk;
+	/**
+	 * @brief The index of the face in the mesh level
+	*/
+	int face;
+	/**
+	 * @brief The index of the first outline of the face in the mesh level
+	*/
+	int outline_begin;
+	/**
+	 * @brief The index past the last outline of the face in the mesh level
+	*/
+	int outline_end;
+} RasterRef;
+
+/**
+ * @brief Rasterize a face of a mesh level and its outlines on a framebuffer
+ * @param fb The framebuffer
+ * @param origin The origin of the 2D plane
+ * @param level The mesh level
+ * @param shades The shade table the occluded faces are drawn with
+ * @param ref The face and its outlines
+ * @param clip The part of the framebuffer to draw in
+ * @param outlines Whether to draw the outlines of the face
+ * @param pick The picking buffer to draw the ID of the face on (nullptr for none)
+ * @note The outlines of a face are drawn right after it so the nearer faces still hide them
+ * @note Only the faces with occluded corners are shaded per pixel, the opaque ones by looking up the shade table,
+ * @note the others are filled flat
+*/
+void raster_face(Framebuffer* fb, coords origin, ChunkMeshLevel& level, const ShadeTable* shades, RasterRef ref, SDL_Rect clip, bool outlines, PickBuffer* pick = nullptr) {
+	MeshFace& face = level.faces[ref.face];
+	std::array<coords, 4> corners;
+	for(int i = 0; i < 4; i++) {
+		corners[i] = {origin.x + face.corners[i].x, origin.y + face.corners[i].y};
+	}
+	if(!Face_occluded(face.ao)) {
+		Framebuffer_fill_quad(fb, corners, face.color, clip);
+	} else if(face.color.a == 255) {
+		Framebuffer_fill_quad_ramp(fb, corners, ShadeTable_ramp(shades, face.block), Face_corner_shades(face.shade, face.ao), clip);
+	} else {
+		Framebuffer_fill_quad_shaded(fb, corners, shades->palette.colors[face.block.id], Face_corner_shades(face.shade, face.ao), clip);
+	}
+	if(pick) {
+		PickBuffer_fill_quad(pick, corners, Pick_encode(face.pos, face.face), clip);
+	}
+
+	if(!outlines) {
+		return;
+	}
+	for(int i = ref.outline_begin; i < ref.outline_end; i++) {
+		MeshOutline& outline = level.outlines[i];
+		Framebuffer_draw_line(
+			fb,
+			{origin.x + outline.from.x, origin.y + outline.from.y},
+			{origin.x + outline.to.x, origin.y + outline.to.y},
+			RASTER_OUTLINE_COLOR,
+			clip
+		);
+	}
+}
+
+/**
+ * @brief Rasterize the cached chunk meshes on a framebuffer
+ * @param fb The framebuffer
+ * @param config The SDL3 configuration
+ * @param mesher The chunk mesher
+ * @param view The part of the framebuffer to draw in (nullptr for all of it)
+ * @param lod The level of detail of the meshes to draw
+ * @param outlines Whether to draw the outlines of the faces over them
+ * @param pick The picking buffer to draw the IDs of the visible faces on (nullptr for none)
+ * @note The faces are filled from back to front, so the nearest one covers a pixel and see-through faces are blended
+*/
+void raster_chunk_meshes(Framebuffer* fb, SDL3_Config* config, ChunkMesher* mesher, SDL_Rect* view = nullptr, int lod = 0, bool outlines = true, PickBuffer* pick = nullptr) {
+	SDL_Rect clip = Framebuffer_clip(fb, view);
+	coords origin = config->origin;
+	for(int index : mesher->drawn) {
+		SDL_Rect bounds = mesher->bounds[index];
+		bounds.x += origin.x;
+		bounds.y += origin.y;
+		if(!SDL_HasIntersection(&bounds, &clip)) {
+			continue;
+		}
+		ChunkMeshLevel& level = mesher->slots[index].current->levels[lod];
+		int outline = 0;
+		for(int f = 0; f < (int)level.faces.size(); f++) {
+			RasterRef ref = {index, f, outline, outline};
+			for(; ref.outline_end < (int)level.outlines.size() && level.outlines[ref.outline_end].face == f; ref.outline_end++);
+			outline = ref.outline_end;
+			raster_face(fb, origin, level, &mesher->shades, ref, clip, outlines, pick);
+		}
+	}
+}
+
+/**
+ * @brief Bin the faces of the visible chunk meshes in the screen tiles they overlap
+ * @param clip The part of the framebuffer the tiles cover
+ * @param origin The origin of the 2D plane
+ * @param mesher The chunk mesher
+ * @param lod The level of detail of the meshes
+ * @return The faces overlapping each tile (row by row, RASTER_TILE_SIZE pixels wide), in painter's order
+ * @note The bounding box of a face includes the outline pixels on its far edges
+*/
+std::vector<std::vector<RasterRef>> raster_bin_faces(SDL_Rect clip, coords origin, ChunkMesher* mesher, int lod) {
+	int columns = (clip.w + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+	int rows = (clip.h + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+	std::vector<std::vector<RasterRef>> bins(columns * rows);
+	if(bins.empty()) {
+		return bins;
+	}
+	for(int index : mesher->drawn) {
+		SDL_Rect bounds = mesher->bounds[index];
+		bounds.x += origin.x;
+		bounds.y += origin.y;
+		if(!SDL_HasIntersection(&bounds, &clip)) {
+			continue;
+		}
+		ChunkMeshLevel& level = mesher->slots[index].current->levels[lod];
+		int outline = 0;
+		for(int f = 0; f < (int)level.faces.size(); f++) {
+			RasterRef ref = {index, f, outline, outline};
+			for(; ref.outline_end < (int)level.outlines.size() && level.outlines[ref.outline_end].face == f; ref.outline_end++);
+			outline = ref.outline_end;
+
+			auto& corners = level.faces[f].corners;
+			int min_x = corners[0].x, max_x = corners[0].x, min_y = corners[0].y, max_y = corners[0].y;
+			for(auto& corner : corners) {
+				min_x = std::min(min_x, corner.x);
+				max_x = std::max(max_x, corner.x);
+				min_y = std::min(min_y, corner.y);
+				max_y = std::max(max_y, corner.y);
+			}
+			if(origin.x + max_x < clip.x || origin.y + max_y < clip.y) {
+				continue;
+			}
+			int column0 = std::max((origin.x + min_x - clip.x) / RASTER_TILE_SIZE, 0);
+			int column1 = std::min((origin.x + max_x - clip.x) / RASTER_TILE_SIZE, columns - 1);
+			int row0 = std::max((origin.y + min_y - clip.y) / RASTER_TILE_SIZE, 0);
+			int row1 = std::min((origin.y + max_y - clip.y) / RASTER_TILE_SIZE, rows - 1);
+			for(int row = row0; row <= row1; row++) {
+				for(int column = column0; column <= column1; column++) {
+					bins[column + row * columns].push_back(ref);
+				}
+			}
+		}
+	}
+	return bins;
+}
+
+/**
+ * @brief Get the rectangle of a screen tile
+ * @param clip The part of the framebuffer the tiles cover
+ * @param tile The index of the tile, row by row
+ * @return The rectangle of the tile, clipped
+*/
+SDL_Rect raster_tile_rect(SDL_Rect clip, int tile) {
+	int columns = (clip.w + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+	SDL_Rect rect = {clip.x + tile % columns * RASTER_TILE_SIZE, clip.y + tile / columns * RASTER_TILE_SIZE, RASTER_TILE_SIZE, RASTER_TILE_SIZE};
+	rect.w = std::min(rect.w, clip.x + clip.w - rect.x);
+	rect.h = std::min(rect.h, clip.y + clip.h - rect.y);
+	return rect;
+}
+
+/**
+ * @brief Rasterize the cached chunk meshes on a framebuffer, in parallel over screen tiles
+ * @param fb The framebuffer
+ * @param config The SDL3 configuration
+ * @param mesher The chunk mesher
+ * @param jobs The job system the screen tiles are rasterized on
+ * @param view The part of the framebuffer to draw in (nullptr for all of it)
+ * @param lod The level of detail of the meshes to draw
+ * @param outlines Whether to draw the outlines of the faces over them
+ * @param pick The picking buffer to draw the IDs of the visible faces on (nullptr for none)
+ * @note The faces are first binned in the tiles they overlap, in painter's order, then each tile is rasterized on its own,
+ * @note clipped to the tile, so the workers never write the same pixel and the image is the same as raster_chunk_meshes
+*/
+void raster_chunk_meshes_tiled(Framebuffer* fb, SDL3_Config* config, ChunkMesher* mesher, JobSystem* jobs, SDL_Rect* view = nullptr, int lod = 0, bool outlines = true, PickBuffer* pick = nullptr) {
+	SDL_Rect clip = Framebuffer_clip(fb, view);
+	coords origin = config->origin;
+	auto bins = raster_bin_faces(clip, origin, mesher, lod);
+
+	JobSystem_parallel_for(jobs, bins.size(), [&](int tile) {
+		SDL_Rect tile_clip = raster_tile_rect(clip, tile);
+		for(RasterRef ref : bins[tile]) {
+			raster_face(fb, origin, mesher->slots[ref.chunk].current->levels[lod], &mesher->shades, ref, tile_clip, outlines, pick);
+		}
+	}, 1);
+}
+
+/**
+ * @brief The depth of a face over the screen, an affine function of the pixel coordinates
+*/
+typedef struct RasterDepthPlane {
+	/**
+	 * @brief The depth at the center of the pixel (0, 0)
+	*/
+	double depth;
+	/**
+	 * @brief The change of depth from a pixel to the next one along x
+	*/
+	double dx;
+	/**
+	 * @brief The change of depth from a pixel to the next one along y
+	*/
+	double dy;
+} RasterDepthPlane;
+
+/**
+ * @brief Get the depth plane of a face
+ * @param face The face
+ * @param config The SDL3 configuration
+ * @return The depth plane of the face
+ * @note The depth of a point is its dot product with the camera vector (with unit components),
+ * @note found on a pixel by sliding the point of the plane y = 0 under it along the camera vector up to the face
+*/
+RasterDepthPlane RasterDepthPlane_new(MeshFace& face, SDL3_Config* config) {
+	std::array<int, 3> s = {
+		config->cam_vec.x < 0 ? -1 : 1,
+		config->cam_vec.y < 0 ? -1 : 1,
+		config->cam_vec.z < 0 ? -1 : 1
+	};
+	int axis = face.face / 2;
+	std::array<int, 3> pos = {face.pos.x, face.pos.y, face.pos.z};
+	double plane = pos[axis] + (face.face % 2 ? face.size : 0);
+
+	auto depth = [&](double x, double y) {
+		vec3 point = get_3d_point(x + 0.5 - config->origin.x, y + 0.5 - config->origin.y, config);
+		std::array<double, 3> p = {point.x, point.y, point.z};
+		// Moving by t against the camera vector lowers the depth by 3t
+		double t = (p[axis] - plane) * s[axis];
+		return s[0] * p[0] + s[1] * p[1] + s[2] * p[2] - 3 * t;
+	};
+	double depth0 = depth(0, 0);
+	return {depth0, depth(1, 0) - depth0, depth(0, 1) - depth0};
+}
+
+/**
+ * @brief Get the depth of a face on a pixel
+ * @param plane The depth plane of the face
+ * @param x The x coordinate of the pixel
+ * @param y The y coordinate of the pixel
+ * @return The depth, rounded the same way every time
+*/
+float RasterDepthPlane_at(RasterDepthPlane plane, int x, int y) {
+	return (float)(plane.depth + plane.dx * x + plane.dy * y);
+}
+
+/**
+ * @brief Rasterize the cached chunk meshes on a framebuffer with a depth buffer, in parallel over screen tiles
+ * @param fb The framebuffer
+ * @param depth The depth buffer, of the size of the framebuffer
+ * @param config The SDL3 configuration
+ * @param mesher The chunk mesher
+ * @param jobs The job system the screen tiles are rasterized on
+ * @param view The part of the framebuffer to draw in (nullptr for all of it)
+ * @param lod The level of detail of the meshes to draw
+ * @param outlines Whether to draw the outlines of the faces over them
+ * @param pick The picking buffer to draw the IDs of the visible faces on (nullptr for none)
+ * @note A first pass writes the depth of the opaque faces only (early-z), then the faces are shaded only on the pixels
+ * @note where they are the nearest opaque surface, or in front of it for the see-through ones (blended in painter's order),
+ * @note with their ambient occlusion interpolated between their corners. The runs of visible pixels of a row are drawn as spans.
+ * @note The outlines are drawn last, where they lie on the nearest surface.
+*/
+void raster_chunk_meshes_depth(Framebuffer* fb, DepthBuffer* depth, SDL3_Config* config, ChunkMesher* mesher, JobSystem* jobs, SDL_Rect* view = nullptr, int lod = 0, bool outlines = true, PickBuffer* pick = nullptr) {
+	SDL_Rect clip = Framebuffer_clip(fb, view);
+	coords origin = config->origin;
+	auto bins = raster_bin_faces(clip, origin, mesher, lod);
+	uint32_t* pixels = fb->pixels.data();
+	float* values = depth->values.data();
+	int width = fb->width;
+
+	JobSystem_parallel_for(jobs, bins.size(), [&](int tile) {
+		SDL_Rect tile_clip = raster_tile_rect(clip, tile);
+		DepthBuffer_clear(depth, &tile_clip);
+
+		auto& refs = bins[tile];
+		std::vector<RasterDepthPlane> planes(refs.size());
+		std::vector<std::array<coords, 4>> quads(refs.size());
+		for(int i = 0; i < (int)refs.size(); i++) {
+			MeshFace& face = mesher->slots[refs[i].chunk].current->levels[lod].faces[refs[i].face];
+			planes[i] = RasterDepthPlane_new(face, config);
+			for(int c = 0; c < 4; c++) {
+				quads[i][c] = {origin.x + face.corners[c].x, origin.y + face.corners[c].y};
+			}
+		}
+
+		// Early-z: keep the depth of the nearest opaque face on each pixel
+		for(int i = 0; i < (int)refs.size(); i++) {
+			if(mesher->slots[refs[i].chunk].current->levels[lod].faces[refs[i].face].color.a != 255) {
+				continue;
+			}
+			scan_quad(quads[i], tile_clip, [&](int x, int y) {
+				float& value = values[y * width + x];
+				value = std::max(value, RasterDepthPlane_at(planes[i], x, y));
+			});
+		}
+
+		// Shade the pixels the faces are visible on
+		for(int i = 0; i < (int)refs.size(); i++) {
+			MeshFace& face = mesher->slots[refs[i].chunk].current->levels[lod].faces[refs[i].face];
+			RGBA rgba = face.color;
+			uint32_t color = RGBA_pack(rgba);
+			uint32_t id = Pick_encode(face.pos, face.face);
+			// The ambient occlusion interpolated over the face, only on the faces with occluded corners, the opaque ones looking up the shade table
+			bool occluded = Face_occluded(face.ao);
+			std::array<uint8_t, 4> shades = Face_corner_shades(face.shade, face.ao);
+			QuadCoords uv = occluded ? QuadCoords_new(quads[i]) : QuadCoords{};
+			const uint32_t* ramp = ShadeTable_ramp(&mesher->shades, face.block);
+			RGBA base = mesher->shades.palette.colors[face.block.id];
+			scan_quad_spans(quads[i], tile_clip, [&](int y, int begin, int end) {
+				uint32_t* row = pixels + y * width;
+				// The runs of pixels the face is visible on are drawn at once, the opaque flat ones filled, the see-through flat ones blended as spans
+				for(int x = begin; x < end;) {
+					if(RasterDepthPlane_at(planes[i], x, y) < values[y * width + x]) {
+						x++;
+						continue;
+					}
+					int run = x + 1;
+					while(run < end && RasterDepthPlane_at(planes[i], run, y) >= values[y * width + run]) {
+						run++;
+					}
+					if(occluded) {
+						uint32_t* span = row + x;
+						QuadRow_span(QuadRow_new(uv, x, y), shades, run - x, [&](int px, int shade) {
+							span[px] = rgba.a == 255 ? ramp[shade] : RGBA_blend(span[px], RGBA_scale(base, shade));
+						});
+					} else if(rgba.a == 255) {
+						std::fill(row + x, row + run, color);
+					} else {
+						RGBA_blend_span(row + x, run - x, rgba);
+					}
+					if(pick) {
+						std::fill(pick->ids.data() + y * pick->width + x, pick->ids.data() + y * pick->width + run, id);
+					}
+					x = run;
+				}
+			});
+		}
+
+		if(!outlines) {
+			return;
+		}
+		// The outline pixels lie up to a pixel off their face, so they are kept within two pixels of depth change of it
+		for(int i = 0; i < (int)refs.size(); i++) {
+			ChunkMeshLevel& level = mesher->slots[refs[i].chunk].current->levels[lod];
+			double bias = 2 * (std::abs(planes[i].dx) + std::abs(planes[i].dy));
+			for(int o = refs[i].outline_begin; o < refs[i].outline_end; o++) {
+				MeshOutline& outline = level.outlines[o];
+				coords from = {origin.x + outline.from.x, origin.y + outline.from.y};
+				coords to = {origin.x + outline.to.x, origin.y + outline.to.y};
+				for(auto p : linegen(from, to).line_vec) {
+					if(p.x < tile_clip.x || p.y < tile_clip.y || p.x >= tile_clip.x + tile_clip.w || p.y >= tile_clip.y + tile_clip.h) {
+						continue;
+					}
+					if(RasterDepthPlane_at(planes[i], p.x, p.y) + bias >= values[p.y * width + p.x]) {
+						Framebuffer_draw_pixel(fb, p.x, p.y, RASTER_OUTLINE_COLOR);
+					}
+				}
+			}
+		}
+	}, 1);
+}
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef __AQUICE_SDL3_RAYCAST_HPP__
+#define __AQUICE_SDL3_RAYCAST_HPP__
+
+#include <array>
+
+#include "SDL.hpp"
+#include "world.hpp"
+#include "ray.hpp"
+#include "light.hpp"
+#include "ao.hpp"
+#include "shadow.hpp"
+#include "shade.hpp"
+#include "pick.hpp"
+#include "../SDL2/framebuffer.hpp"
+#include "../utils/jobs.hpp"
+
+/**
+ * @brief The size of the square screen tiles raycast by a worker at once
+*/
+#define RAYCAST_TILE_SIZE 64
+/**
+ * @brief The maximum number of see-through blocks blended on a pixel
+*/
+#define RAYCAST_MAX_LAYERS 32
+/**
+ * @brief The number of faces whose shading a screen tile keeps, a power of two
+*/
+#define RAYCAST_FACE_CACHE 256
+
+/**
+ * @brief The shading of a face crossed by the rays of a screen tile
+*/
+typedef struct RaycastFace {
+	/**
+	 * @brief The face, as encoded by Pick_encode (0 for none)
+	*/
+	uint32_t id;
+	/**
+	 * @brief The brightness of the corners of the face, out of 255, in the order of the corners
+	*/
+	std::array<uint8_t, 4> shades;
+	/**
+	 * @brief Whether the corners of the face are occluded, its brightness being interpolated between them
+	*/
+	bool occluded;
+} RaycastFace;
+
+/**
+ * @brief The shading of the faces crossed by the rays of a screen tile, indexed by a hash of the face
+ * @note The light, the sun and the occlusion of a face are looked up in the world once for all the pixels crossing it
+*/
+typedef std::array<RaycastFace, RAYCAST_FACE_CACHE> RaycastFaceCache;
+
+/**
+ * @brief Get the shading of a face of a world, from a face cache
+ * @param cache The face cache
+ * @param world The world
+ * @param config The SDL3 configuration
+ * @param pos The position of the block of the face
+ * @param face The face
+ * @return The shading of the face, computed and kept in the cache if it was not there
+*/
+const RaycastFace& RaycastFaceCache_get(RaycastFaceCache* cache, World* world, SDL3_Config* config, coords3 pos, Face face) {
+	uint32_t id = Pick_encode(pos, face);
+	RaycastFace& entry = (*cache)[id * 2654435761u >> 24 & (RAYCAST_FACE_CACHE - 1)];
+	if(entry.id != id) {
+		int shade = Face_shade(face, World_face_light(world, pos, face), World_face_sunlit(world, pos, face, config->sun_vec));
+		std::array<uint8_t, 4> ao = World_face_ao(world, pos, face);
+		entry.id = id;
+		entry.occluded = Face_occluded(ao);
+		entry.shades = entry.occluded ? Face_corner_shades(shade, ao) : std::array<uint8_t, 4>{(uint8_t)shade, (uint8_t)shade, (uint8_t)shade, (uint8_t)shade};
+	}
+	return entry;
+}
+
+/**
+ * @brief Raycast a pixel of a framebuffer
+ * @param fb The framebuffer, holding the background of the pixel
+ * @param world The world
+ * @param config The SDL3 configuration
+ * @param x The x coordinate of the pixel
+ * @param y The y coordinate of the pixel
+ * @param cache The shading of the faces already crossed by the rays of the screen tile
+ * @param pick The picking buffer to draw the ID of the nearest face crossed on (nullptr for none)
+ * @note The ray through the center of the pixel goes parallel to the camera vector, the blocks it crosses up to the
+ * @note first opaque one are then shaded from the orientation of the face crossed, the light of the block in front of it,
+ * @note the sun and the ambient occlusion of its corners interpolated at the point crossed, and blended from back to front,
+ * @note exactly like the mesh path does
+*/
+void raycast_pixel(Framebuffer* fb, World* world, SDL3_Config* config, int x, int y, RaycastFaceCache* cache, PickBuffer* pick = nullptr) {
+	vec3 origin = get_3d_point(x + 0.5 - config->origin.x, y + 0.5 - config->origin.y, config);
+	vec3 dir = {
+		config->cam_vec.x < 0 ? 1.0 : -1.0,
+		config->cam_vec.y < 0 ? 1.0 : -1.0,
+		config->cam_vec.z < 0 ? 1.0 : -1.0
+	};
+
+	std::array<RGBA, RAYCAST_MAX_LAYERS> layers;
+	int count = 0;
+	World_march(world, origin, dir, [&](coords3 pos, Face face, double t, Block block) {
+		if(count == 0 && pick) {
+			PickBuffer_draw_pixel(pick, x, y, Pick_encode(pos, face));
+		}
+		const RaycastFace& shading = RaycastFaceCache_get(cache, world, config, pos, face);
+		int shade = shading.shades[0];
+		if(shading.occluded) {
+			// The position of the point crossed on the face along its tangent axes, in the order of its corners
+			std::array<double, 3> point = {origin.x + dir.x * t - pos.x, origin.y + dir.y * t - pos.y, origin.z + dir.z * t - pos.z};
+			int axis = face / 2;
+			shade = Quad_bilinear(shading.shades, point[axis == 0 ? 1 : 0], point[axis == 2 ? 1 : 2]);
+		}
+		layers[count++] = RGBA_scale(world->palette.colors[block.id], shade);
+		return !Block_is_opaque(&world->palette, block) && count < RAYCAST_MAX_LAYERS;
+	});
+
+	for(int i = count - 1; i >= 0; i--) {
+		Framebuffer_draw_pixel(fb, x, y, layers[i]);
+	}
+}
+
+/**
+ * @brief Render a world on a framebuffer by raycasting every pixel
+ * @param fb The framebuffer, holding the background
+ * @param world The world
+ * @param config The SDL3 configuration
+ * @param jobs The job system the screen tiles are raycast on
+ * @param view The part of the framebuffer to draw in (nullptr for all of it)
+ * @param pick The picking buffer to draw the IDs of the visible faces on (nullptr for none)
+ * @note This is an alternative to the mesh path (raster_chunk_meshes without outlines) producing the same image
+ * @note Each screen tile shades the faces its rays cross once, in a face cache of its own
+*/
+void raycast_world(Framebuffer* fb, World* world, SDL3_Config* config, JobSystem* jobs, SDL_Rect* view = nullptr, PickBuffer* pick = nullptr) {
+	SDL_Rect clip = Framebuffer_clip(fb, view);
+	int columns = (clip.w + RAYCAST_TILE_SIZE - 1) / RAYCAST_TILE_SIZE;
+	int rows = (clip.h + RAYCAST_TILE_SIZE - 1) / RAYCAST_TILE_SIZE;
+
+	JobSystem_parallel_for(jobs, columns * rows, [&](int tile) {
+		int x0 = clip.x + tile % columns * RAYCAST_TILE_SIZE;
+		int y0 = clip.y + tile / columns * RAYCAST_TILE_SIZE;
+		int x1 = std::min(x0 + RAYCAST_TILE_SIZE, clip.x + clip.w);
+		int y1 = std::min(y0 + RAYCAST_TILE_SIZE, clip.y + clip.h);
+		RaycastFaceCache cache;
+		cache.fill({0, {}, false});
+		for(int y = y0; y < y1; y++) {
+			for(int x = x0; x < x1; x++) {
+				raycast_pixel(fb, world, config, x, y, &cache, pick);
+			}
+		}
+	}, 1);
+}
+
+#endif
@@ -0,0 +1,578 @@
+#ifndef __AQUICE_SDL3_REGION_HPP__
+#define __AQUICE_SDL3_REGION_HPP__
+
+#include <array>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <list>
+#include <memory>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+#include "SDL.hpp"
+#include "world.hpp"
+#include "stream.hpp"
+#include "../utils/jobs.hpp"
+
+/**
+ * @brief The number of chunks along x and z of a region
+ * @note A region holds every chunk of its columns, from the bottom to the top of the world
+*/
+#define REGION_SIZE 16
+/**
+ * @brief The number of chunks of a region
+*/
+#define REGION_CHUNK_COUNT (REGION_SIZE * Y_CHUNK_COUNT * REGION_SIZE)
+/**
+ * @brief The magic number starting a region file
+*/
+#define REGION_MAGIC 0x47525141
+/**
+ * @brief The version of the region file format
+*/
+#define REGION_VERSION 1
+/**
+ * @brief The number of region files a region store keeps open
+*/
+#define REGION_OPEN_FILES 16
+
+/**
+ * @brief The encodings of the blocks of a chunk
+*/
+typedef enum ChunkEncoding {
+	CHUNK_ENCODING_RLE,
+	CHUNK_ENCODING_RAW
+} ChunkEncoding;
+
+/**
+ * @brief The place of a chunk in a region file
+*/
+typedef struct RegionEntry {
+	/**
+	 * @brief The offset of the compressed chunk in the file
+	*/
+	uint32_t offset;
+	/**
+	 * @brief The size of the compressed chunk (0 if the chunk is not stored)
+	*/
+	uint32_t size;
+	/**
+	 * @brief The size reserved for the chunk, which it can be rewritten in place within
+	*/
+	uint32_t capacity;
+} RegionEntry;
+
+/**
+ * @brief An open region file
+ * @note The file starts with the magic number, the version and the offset table, followed by the compressed chunks
+*/
+typedef struct RegionFile {
+	/**
+	 * @brief The position of the region, in regions
+	*/
+	coords3 region;
+	/**
+	 * @brief The file (nullptr if it is missing or invalid)
+	*/
+	FILE* file;
+	/**
+	 * @brief The offset table, indexed by Region_chunk_index
+	*/
+	std::array<RegionEntry, REGION_CHUNK_COUNT> table;
+} RegionFile;
+
+/**
+ * @brief A chunk read in the background
+*/
+typedef struct RegionRead {
+	/**
+	 * @brief The state of the read, CHUNK_LOAD_PENDING until the I/O job is done
+	*/
+	std::atomic<ChunkLoadState> state;
+	/**
+	 * @brief The chunk whose blocks are read
+	*/
+	Chunk chunk;
+} RegionRead;
+
+/**
+ * @brief A store of the chunks of an unbounded world in region files, read and written by background I/O jobs
+ * @note The region files are named <path>.<x>.<z>.region and the palette of the world <path>.palette
+*/
+typedef struct RegionStore {
+	/**
+	 * @brief The path prefix of the files
+	*/
+	std::string path;
+	/**
+	 * @brief The job system the reads and writes run on
+	*/
+	JobSystem* jobs;
+	/**
+	 * @brief The last I/O job, each one being a continuation of the previous so the reads and writes run in the order they are asked for
+	*/
+	JobHandle last;
+	/**
+	 * @brief The region files looked up, from the most recently used one, at most REGION_OPEN_FILES (only used by the I/O jobs)
+	*/
+	std::list<RegionFile*> open;
+	/**
+	 * @brief The region files looked up, by region position (only used by the I/O jobs)
+	*/
+	std::unordered_map<coords3, std::list<RegionFile*>::iterator, ChunkPosHash, ChunkPosEqual> files;
+	/**
+	 * @brief The chunks being read, by position, until their load is collected
+	*/
+	std::unordered_map<coords3, std::shared_ptr<RegionRead>, ChunkPosHash, ChunkPosEqual> reads;
+	/**
+	 * @brief The number of colors of the palette last saved, or loaded
+	*/
+	int palette_count;
+} RegionStore;
+
+/**
+ * @brief Compress the blocks of a chunk with a palette and run-length encoding
+ * @param blocks The blocks of the chunk
+ * @return The compressed blocks
+ * @note The format is the encoding, then for CHUNK_ENCODING_RLE the number of distinct blocks minus one and the blocks
+ * @note themselves, then (unless there is only one) the runs of the blocks in memory order, each as the index of the block
+ * @note in that palette and a LEB128 length. Chunks too noisy for it are stored raw (CHUNK_ENCODING_RAW).
+*/
+std::vector<uint8_t> ChunkBlocks_compress(const ChunkBlocks& blocks) {
+	const uint8_t* ids = &blocks[0][0][0].id;
+	int count = X_CHUNK_SIZE * Y_CHUNK_SIZE * Z_CHUNK_SIZE;
+
+	std::array<int, PALETTE_SIZE> local;
+	local.fill(-1);
+	std::vector<uint8_t> palette;
+	for(int i = 0; i < count; i++) {
+		if(local[ids[i]] < 0) {
+			local[ids[i]] = palette.size();
+			palette.push_back(ids[i]);
+		}
+	}
+
+	std::vector<uint8_t> data;
+	data.push_back(CHUNK_ENCODING_RLE);
+	data.push_back(palette.size() - 1);
+	data.insert(data.end(), palette.begin(), palette.end());
+	if(palette.size() == 1) {
+		return data;
+	}
+	for(int i = 0; i < count;) {
+		int run = 1;
+		while(i + run < count && ids[i + run] == ids[i]) {
+			run++;
+		}
+		data.push_back(local[ids[i]]);
+		for(int length = run; ; length >>= 7) {
+			data.push_back((length & 0x7F) | (length >= 0x80 ? 0x80 : 0));
+			if(length < 0x80) {
+				break;
+			}
+		}
+		i += run;
+	}
+	if((int)data.size() > 1 + count) {
+		data.assign(1, CHUNK_ENCODING_RAW);
+		data.insert(data.end(), ids, ids + count);
+	}
+	return data;
+}
+
+/**
+ * @brief Decompress the blocks of a chunk
+ * @param data The compressed blocks
+ * @param size The size of the compressed blocks
+ * @param blocks The blocks to fill
+ * @return Whether the compressed blocks were valid
+*/
+bool ChunkBlocks_decompress(const uint8_t* data, size_t size, ChunkBlocks* blocks) {
+	uint8_t* ids = &(*blocks)[0][0][0].id;
+	int count = X_CHUNK_SIZE * Y_CHUNK_SIZE * Z_CHUNK_SIZE;
+	if(size >= 1 && data[0] == CHUNK_ENCODING_RAW) {
+		if(size != 1 + (size_t)count) {
+			return false;
+		}
+		std::memcpy(ids, data + 1, count);
+		return true;
+	}
+	if(size < 2 || data[0] != CHUNK_ENCODING_RLE) {
+		return false;
+	}
+	data++;
+	size--;
+	if(size < 2 + (size_t)data[0]) {
+		return false;
+	}
+	int colors = data[0] + 1;
+	const uint8_t* palette = data + 1;
+	if(colors == 1) {
+		std::memset(ids, palette[0], count);
+		return true;
+	}
+
+	size_t at = 1 + colors;
+	int i = 0;
+	while(i < count) {
+		if(at >= size || data[at] >= colors) {
+			return false;
+		}
+		uint8_t id = palette[data[at++]];
+		int run = 0;
+		for(int shift = 0; ; shift += 7) {
+			if(at >= size || shift > 14) {
+				return false;
+			}
+			run |= (data[at] & 0x7F) << shift;
+			if(!(data[at++] & 0x80)) {
+				break;
+			}
+		}
+		if(run == 0 || i + run > count) {
+			return false;
+		}
+		std::memset(ids + i, id, run);
+		i += run;
+	}
+	return true;
+}
+
+/**
+ * @brief Get the index of a chunk in its region
+ * @param pos The position of the chunk, in chunks
+ * @return The index of the chunk
+*/
+int Region_chunk_index(coords3 pos) {
+	int x = pos.x - floor_div(pos.x, REGION_SIZE) * REGION_SIZE;
+	int z = pos.z - floor_div(pos.z, REGION_SIZE) * REGION_SIZE;
+	return x + REGION_SIZE * (pos.y + Y_CHUNK_COUNT * z);
+}
+
+/**
+ * @brief Create a new region store
+ * @param path The path prefix of the files
+ * @param jobs The job system to read and write on
+ * @return The region store pointer
+*/
+RegionStore* RegionStore_new(std::string path, JobSystem* jobs) {
+	RegionStore* store = new RegionStore();
+	store->path = path;
+	store->jobs = jobs;
+	store->palette_count = 0;
+	return store;
+}
+
+/**
+ * @brief Queue an I/O job after the ones asked for before
+ * @param store The region store
+ * @param task The task of the job
+ * @return The handle of the job
+ * @note The region store is used by a single thread, the I/O jobs running on any worker one after the other
+*/
+JobHandle RegionStore_queue(RegionStore* store, std::function<void()> task) {
+	store->last = JobSystem_then(store->jobs, store->last, std::move(task));
+	return store->last;
+}
+
+/**
+ * @brief Close a region file of a region store
+ * @param store The region store
+ * @param file The region file, forgotten by the store
+ * @note Only called by the I/O jobs
+*/
+void RegionStore_close(RegionStore* store, std::list<RegionFile*>::iterator file) {
+	if((*file)->file) {
+		std::fclose((*file)->file);
+	}
+	store->files.erase((*file)->region);
+	delete *file;
+	store->open.erase(file);
+}
+
+/**
+ * @brief Open the region file of a chunk, creating it if needed
+ * @param store The region store
+ * @param pos The position of the chunk, in chunks
+ * @param create Whether to create the file if it does not exist
+ * @return The region file, or nullptr if it does not exist or is invalid
+ * @note Only called by the I/O jobs, a file found missing or invalid is only looked for again to create it
+ * @note The least recently used files are closed past REGION_OPEN_FILES, the missing ones included
+*/
+RegionFile* RegionStore_open(RegionStore* store, coords3 pos, bool create) {
+	coords3 region = {floor_div(pos.x, REGION_SIZE), 0, floor_div(pos.z, REGION_SIZE)};
+	auto found = store->files.find(region);
+	if(found != store->files.end()) {
+		store->open.splice(store->open.begin(), store->open, found->second);
+		RegionFile* file = *found->second;
+		if(file->file || !create) {
+			return file->file ? file : nullptr;
+		}
+		RegionStore_close(store, found->second);
+	}
+
+	std::string name = store->path + "." + std::to_string(region.x) + "." + std::to_string(region.z) + ".region";
+	RegionFile* file = new RegionFile();
+	file->region = region;
+	file->file = std::fopen(name.c_str(), "rb+");
+	if(file->file) {
+		uint32_t header[2];
+		if(std::fread(header, sizeof(header), 1, file->file) != 1
+			|| header[0] != REGION_MAGIC
+			|| header[1] != REGION_VERSION
+			|| std::fread(file->table.data(), sizeof(file->table), 1, file->file) != 1) {
+			std::fclose(file->file);
+			file->file = nullptr;
+		}
+	} else if(create) {
+		file->file = std::fopen(name.c_str(), "wb+");
+		uint32_t header[2] = {REGION_MAGIC, REGION_VERSION};
+		file->table = {};
+		if(file->file && (std::fwrite(header, sizeof(header), 1, file->file) != 1
+			|| std::fwrite(file->table.data(), sizeof(file->table), 1, file->file) != 1
+			|| std::fflush(file->file) != 0)) {
+			std::fclose(file->file);
+			file->file = nullptr;
+		}
+	}
+	store->open.push_front(file);
+	store->files[region] = store->open.begin();
+	while(store->open.size() > REGION_OPEN_FILES) {
+		RegionStore_close(store, std::prev(store->open.end()));
+	}
+	return file->file ? file : nullptr;
+}
+
+/**
+ * @brief Read a chunk from its region file
+ * @param store The region store
+ * @param pos The position of the chunk, in chunks
+ * @param chunk The chunk whose blocks to fill
+ * @return Whether the chunk is stored
+ * @note Only called by the I/O jobs, only the chunk is read from the file
+*/
+bool RegionStore_read(RegionStore* store, coords3 pos, Chunk* chunk) {
+	if(pos.y < 0 || pos.y >= Y_CHUNK_COUNT) {
+		return false;
+	}
+	RegionFile* file = RegionStore_open(store, pos, false);
+	if(!file) {
+		return false;
+	}
+	RegionEntry entry = file->table[Region_chunk_index(pos)];
+	if(entry.size == 0) {
+		return false;
+	}
+	std::vector<uint8_t> data(entry.size);
+	if(std::fseek(file->file, entry.offset, SEEK_SET) != 0 || std::fread(data.data(), entry.size, 1, file->file) != 1) {
+		return false;
+	}
+	return ChunkBlocks_decompress(data.data(), data.size(), &chunk->blocks);
+}
+
+/**
+ * @brief Write a compressed chunk to its region file
+ * @param store The region store
+ * @param pos The position of the chunk, in chunks
+ * @param data The compressed blocks of the chunk
+ * @return Whether the chunk was written
+ * @note Only called by the I/O jobs, the chunk is rewritten in place when it fits, appended to the file otherwise
+ * @note The offset table is left as it was when the chunk cannot be written
+*/
+bool RegionStore_write(RegionStore* store, coords3 pos, const std::vector<uint8_t>& data) {
+	if(pos.y < 0 || pos.y >= Y_CHUNK_COUNT) {
+		return false;
+	}
+	RegionFile* file = RegionStore_open(store, pos, true);
+	if(!file) {
+		return false;
+	}
+	int index = Region_chunk_index(pos);
+	RegionEntry entry = file->table[index];
+	if(data.size() > entry.capacity) {
+		long end = std::fseek(file->file, 0, SEEK_END) == 0 ? std::ftell(file->file) : -1;
+		if(end < 0 || (uint64_t)end > UINT32_MAX) {
+			return false;
+		}
+		entry.offset = end;
+		entry.capacity = data.size();
+	} else if(std::fseek(file->file, entry.offset, SEEK_SET) != 0) {
+		return false;
+	}
+	entry.size = data.size();
+	if(std::fwrite(data.data(), data.size(), 1, file->file) != 1 || std::fflush(file->file) != 0) {
+		return false;
+	}
+
+	// The table entry is written after the chunk so a crash never points it to a partial chunk
+	if(std::fseek(file->file, 2 * sizeof(uint32_t) + index * sizeof(RegionEntry), SEEK_SET) != 0
+		|| std::fwrite(&entry, sizeof(RegionEntry), 1, file->file) != 1
+		|| std::fflush(file->file) != 0) {
+		return false;
+	}
+	file->table[index] = entry;
+	return true;
+}
+
+/**
+ * @brief Load a chunk in the background
+ * @param store The region store
+ * @param pos The position of the chunk, in chunks
+ * @param chunk The chunk whose blocks to fill once read
+ * @return Whether the chunk is stored, or CHUNK_LOAD_PENDING until it is read, the load being asked for again to collect it
+ * @note The read runs after the writes asked for before, the calling thread never waits for it
+*/
+ChunkLoadState RegionStore_load(RegionStore* store, coords3 pos, Chunk* chunk) {
+	auto found = store->reads.find(pos);
+	if(found == store->reads.end()) {
+		auto read = std::make_shared<RegionRead>();
+		read->state.store(CHUNK_LOAD_PENDING);
+		RegionStore_queue(store, [store, pos, read] {
+			bool stored = RegionStore_read(store, pos, &read->chunk);
+			read->state.store(stored ? CHUNK_LOAD_DONE : CHUNK_LOAD_MISSING, std::memory_order_release);
+		});
+		store->reads[pos] = read;
+		return CHUNK_LOAD_PENDING;
+	}
+	ChunkLoadState state = found->second->state.load(std::memory_order_acquire);
+	if(state == CHUNK_LOAD_DONE) {
+		chunk->blocks = found->second->chunk.blocks;
+	}
+	if(state != CHUNK_LOAD_PENDING) {
+		store->reads.erase(found);
+	}
+	return state;
+}
+
+/**
+ * @brief Wait for the reads and writes asked for so far
+ * @param store The region store
+*/
+void RegionStore_flush(RegionStore* store) {
+	JobSystem_wait(store->jobs, store->last);
+}
+
+/**
+ * @brief Save the palette of a world in the background
+ * @param store The region store
+ * @param palette The palette, copied before returning
+*/
+void RegionStore_save_palette(RegionStore* store, const Palette* palette) {
+	store->palette_count = palette->count;
+	auto copy = std::make_shared<Palette>(*palette);
+	RegionStore_queue(store, [store, copy] {
+		FILE* file = std::fopen((store->path + ".palette").c_str(), "wb");
+		if(file) {
+			uint32_t count = copy->count;
+			std::fwrite(&count, sizeof(count), 1, file);
+			std::fwrite(copy->colors.data(), sizeof(RGBA), copy->count, file);
+			std::fclose(file);
+		}
+	});
+}
+
+/**
+ * @brief Load the palette of a world
+ * @param store The region store
+ * @param palette The palette to fill
+ * @return Whether the palette is stored
+ * @note Must be called before the chunks referring to it are loaded
+*/
+bool RegionStore_load_palette(RegionStore* store, Palette* palette) {
+	RegionStore_flush(store);
+	FILE* file = std::fopen((store->path + ".palette").c_str(), "rb");
+	if(!file) {
+		return false;
+	}
+	uint32_t count = 0;
+	Palette loaded = {};
+	bool valid = std::fread(&count, sizeof(count), 1, file) == 1
+		&& count >= 1 && count <= PALETTE_SIZE
+		&& std::fread(loaded.colors.data(), sizeof(RGBA), count, file) == count;
+	std::fclose(file);
+	if(valid) {
+		loaded.count = count;
+		loaded.version = palette->version + 1;
+		*palette = loaded;
+		store->palette_count = count;
+	}
+	return valid;
+}
+
+/**
+ * @brief Save a chunk in the background
+ * @param store The region store
+ * @param pos The position of the chunk, in chunks
+ * @param chunk The chunk, compressed before returning so it can be edited right away
+ * @param palette The palette of the world, saved first when it grew since it was last saved so the chunk never refers to colors missing from the file
+*/
+void RegionStore_save(RegionStore* store, coords3 pos, const Chunk* chunk, const Palette* palette) {
+	if(palette->count != store->palette_count) {
+		RegionStore_save_palette(store, palette);
+	}
+	auto data = std::make_shared<std::vector<uint8_t>>(ChunkBlocks_compress(chunk->blocks));
+	RegionStore_queue(store, [store, pos, data] { RegionStore_write(store, pos, *data); });
+}
+
+/**
+ * @brief Save every chunk of a world and its palette in the background
+ * @param store The region store
+ * @param world The world
+ * @param streamer The chunk streamer of the world (nullptr for none), whose chunks are marked saved so they are not saved again on eviction
+ * @note The chunks are only compressed on the calling thread, the render loop never waits for the disk
+ * @note The chunks still being read (or generated by the chunk streamer) hold no blocks yet and are skipped
+*/
+void RegionStore_save_world(RegionStore* store, World* world, ChunkStreamer* streamer = nullptr) {
+	RegionStore_save_palette(store, &world->palette);
+	for(int cz = 0; cz < Z_CHUNK_COUNT; cz++) {
+		for(int cy = 0; cy < Y_CHUNK_COUNT; cy++) {
+			for(int cx = 0; cx < X_CHUNK_COUNT; cx++) {
+				coords3 pos = {world->origin.x + cx, cy, world->origin.z + cz};
+				if(store->reads.count(pos) || (streamer && ChunkStreamer_is_loading(streamer, pos))) {
+					continue;
+				}
+				RegionStore_save(store, pos, World_get_chunk(world, cx, cy, cz), &world->palette);
+				if(streamer) {
+					ChunkStreamer_mark_saved(streamer, pos);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief Get the chunk loader of a region store, for a chunk streamer
+ * @param store The region store
+ * @return The chunk loader
+*/
+ChunkLoader RegionStore_loader(RegionStore* store) {
+	return [store](coords3 pos, Chunk* chunk) { return RegionStore_load(store, pos, chunk); };
+}
+
+/**
+ * @brief Get the chunk saver of a region store, for a chunk streamer
+ * @param store The region store
+ * @param palette The palette of the world, which must outlive the chunk streamer
+ * @return The chunk saver
+*/
+ChunkSaver RegionStore_saver(RegionStore* store, const Palette* palette) {
+	return [store, palette](coords3 pos, const Chunk* chunk) { RegionStore_save(store, pos, chunk, palette); };
+}
+
+/**
+ * @brief Free a region store
+ * @param store The region store pointer
+ * @note The writes asked for are finished first
+*/
+void RegionStore_free(RegionStore* store) {
+	RegionStore_flush(store);
+	while(!store->open.empty()) {
+		RegionStore_close(store, store->open.begin());
+	}
+	delete store;
+}
+
+#endif
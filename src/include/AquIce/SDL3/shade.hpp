@@ -0,0 +1,110 @@
+#ifndef __AQUICE_SDL3_SHADE_HPP__
+#define __AQUICE_SDL3_SHADE_HPP__
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#include "SDL.hpp"
+#include "world.hpp"
+#include "light.hpp"
+#include "shadow.hpp"
+#include "ao.hpp"
+#include "../SDL2/framebuffer.hpp"
+
+/**
+ * @brief The number of brightness levels of a color in a shade table, out of 255 for the full color
+*/
+#define SHADE_LEVELS 256
+
+/**
+ * @brief The brightness of the faces along each axis in full light, out of 255: the two sides and the top of the cubes
+*/
+const std::array<uint8_t, 3> FACE_AXIS_SHADES = {215, 255, 185};
+
+/**
+ * @brief The colors of a palette at every brightness level, packed for the framebuffer
+ * @note Indexed by the rasterizer instead of scaling the colors on each pixel
+*/
+typedef struct ShadeTable {
+	/**
+	 * @brief The palette the table was built for
+	*/
+	Palette palette;
+	/**
+	 * @brief The packed colors, indexed by the palette index of the color times SHADE_LEVELS plus the brightness
+	*/
+	std::vector<uint32_t> colors;
+} ShadeTable;
+
+/**
+ * @brief Create a new shade table, empty until it is updated
+ * @return The shade table
+*/
+ShadeTable ShadeTable_new() {
+	ShadeTable table;
+	table.palette.colors.fill({0, 0, 0, 0});
+	table.palette.count = 0;
+	table.palette.version = 0;
+	return table;
+}
+
+/**
+ * @brief Rebuild a shade table if its palette changed
+ * @param table The shade table
+ * @param palette The palette, always the one of the same world (or a copy of it)
+ * @return Whether the table was rebuilt
+ * @note Only the colors of the palette in use are shaded
+ * @note The palette is told apart from the one the table was built for by its version only
+*/
+bool ShadeTable_update(ShadeTable* table, const Palette* palette) {
+	if(!table->colors.empty() && table->palette.version == palette->version) {
+		return false;
+	}
+	table->palette = *palette;
+	table->colors.assign(PALETTE_SIZE * SHADE_LEVELS, 0);
+	for(int i = 0; i < palette->count; i++) {
+		for(int level = 0; level < SHADE_LEVELS; level++) {
+			table->colors[i * SHADE_LEVELS + level] = RGBA_pack(RGBA_scale(palette->colors[i], level));
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Get the colors of a block at every brightness level
+ * @param table The shade table
+ * @param block The block
+ * @return The packed colors, indexed by the brightness
+*/
+const uint32_t* ShadeTable_ramp(const ShadeTable* table, Block block) {
+	return table->colors.data() + block.id * SHADE_LEVELS;
+}
+
+/**
+ * @brief Get the brightness of a face
+ * @param face The face
+ * @param light The light level of the block in front of the face
+ * @param sunlit Whether the sun reaches the face
+ * @return The brightness, out of 255, from the orientation of the face, its light and the sun
+*/
+uint8_t Face_shade(Face face, uint8_t light, bool sunlit) {
+	int shade = FACE_AXIS_SHADES[face / 2] * Light_factor(light) / 255;
+	return sunlit ? shade : shade * SUN_SHADOW_SHADE / 255;
+}
+
+/**
+ * @brief Get the brightness of the corners of a face
+ * @param shade The brightness of the face
+ * @param ao The ambient occlusion of the corners of the face
+ * @return The brightness of the corners, out of 255, in the order of the corners
+*/
+std::array<uint8_t, 4> Face_corner_shades(uint8_t shade, const std::array<uint8_t, 4>& ao) {
+	std::array<uint8_t, 4> shades;
+	for(int i = 0; i < 4; i++) {
+		shades[i] = shade * AO_SHADES[ao[i]] / 255;
+	}
+	return shades;
+}
+
+#endif
@@ -0,0 +1,300 @@
+#ifndef __AQUICE_SDL3_SHADOW_HPP__
+#define __AQUICE_SDL3_SHADOW_HPP__
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#include "SDL.hpp"
+#include "world.hpp"
+
+/**
+ * @brief The brightness of the faces the sun does not reach, out of 255 for the sunlit ones
+*/
+#define SUN_SHADOW_SHADE 170
+/**
+ * @brief The number of words of a row of blocks of the world along x, one bit per block
+*/
+#define SHADOW_ROW_WORDS (MAX_X_COORD / 64)
+
+static_assert(MAX_X_COORD % 64 == 0, "A row of blocks along x must fill whole words");
+
+/**
+ * @brief A row of blocks of the world along x, one bit per block
+*/
+typedef std::array<uint64_t, SHADOW_ROW_WORDS> ShadowRow;
+
+/**
+ * @brief The sun shadows of a world, cast along the sun vector from layer to layer
+ * @note The shadow map of each chunk column is kept in the shadow masks of the shading of its chunks: a block is in the shadow when
+ * @note the block one step towards the sun is opaque or in the shadow itself, so each layer follows from the one above.
+*/
+typedef struct SunShadows {
+	/**
+	 * @brief The direction of the sun the shadows were cast for, as returned by Sun_direction
+	*/
+	coords3 sun;
+	/**
+	 * @brief The chunks of the world the shadows were cast for, and the blocks whose shadows changed during the update
+	*/
+	ChunkTracker* tracker;
+	/**
+	 * @brief The number of rows of blocks recomputed during the last update
+	*/
+	int rows;
+	/**
+	 * @brief The number of chunks whose shadows changed during the last update
+	*/
+	int updated;
+} SunShadows;
+
+/**
+ * @brief Create new sun shadows
+ * @return The sun shadows pointer, the first update casting the shadows of the whole world
+*/
+SunShadows* SunShadows_new() {
+	SunShadows* shadows = new SunShadows();
+	shadows->sun = {0, 1, 0};
+	shadows->tracker = ChunkTracker_new();
+	shadows->rows = 0;
+	shadows->updated = 0;
+	return shadows;
+}
+
+/**
+ * @brief Free sun shadows
+ * @param shadows The sun shadows pointer
+*/
+void SunShadows_free(SunShadows* shadows) {
+	ChunkTracker_free(shadows->tracker);
+	delete shadows;
+}
+
+/**
+ * @brief Get the direction of the sun from a sun vector
+ * @param sun_vec The vector pointing towards the sun
+ * @return The step towards the sun from a block to the next one: the signs of the x and z components, and 1 along y
+ * @note The sun is always above the world, a vector pointing down is taken as pointing up
+*/
+coords3 Sun_direction(coords3 sun_vec) {
+	return {
+		sun_vec.x < 0 ? -1 : (sun_vec.x > 0 ? 1 : 0),
+		1,
+		sun_vec.z < 0 ? -1 : (sun_vec.z > 0 ? 1 : 0)
+	};
+}
+
+/**
+ * @brief Check whether a face is turned towards the sun
+ * @param face The face
+ * @param sun_vec The vector pointing towards the sun
+ * @return Whether the face is turned towards the sun, the faces along it being turned away
+*/
+bool Face_faces_sun(Face face, coords3 sun_vec) {
+	coords3 normal = Face_normal(face);
+	coords3 sun = Sun_direction(sun_vec);
+	return normal.x * sun.x + normal.y * sun.y + normal.z * sun.z > 0;
+}
+
+/**
+ * @brief Check whether a block is in the shadow, looking into the neighbors of its chunk on the border
+ * @param state The shading of the chunk
+ * @param nshadow The shadow masks of the neighbors of the chunk, indexed by the face they touch
+ * @param x The x coordinate of the block in the chunk (-1 to X_CHUNK_SIZE)
+ * @param y The y coordinate of the block in the chunk (-1 to Y_CHUNK_SIZE)
+ * @param z The z coordinate of the block in the chunk (-1 to Z_CHUNK_SIZE)
+ * @return Whether the block is in the shadow
+ * @note At most one coordinate may be outside the chunk
+*/
+bool ChunkState_shadow_at(const ChunkState* state, const std::array<ChunkMask, FACE_COUNT>& nshadow, int x, int y, int z) {
+	if(x < 0) {
+		return nshadow[FACE_NEG_X][z] & ChunkMask_bit(X_CHUNK_SIZE - 1, y);
+	}
+	if(x >= X_CHUNK_SIZE) {
+		return nshadow[FACE_POS_X][z] & ChunkMask_bit(0, y);
+	}
+	if(y < 0) {
+		return nshadow[FACE_NEG_Y][z] & ChunkMask_bit(x, Y_CHUNK_SIZE - 1);
+	}
+	if(y >= Y_CHUNK_SIZE) {
+		return nshadow[FACE_POS_Y][z] & ChunkMask_bit(x, 0);
+	}
+	if(z < 0) {
+		return nshadow[FACE_NEG_Z][Z_CHUNK_SIZE - 1] & ChunkMask_bit(x, y);
+	}
+	if(z >= Z_CHUNK_SIZE) {
+		return nshadow[FACE_POS_Z][0] & ChunkMask_bit(x, y);
+	}
+	return state->shadow[z] & ChunkMask_bit(x, y);
+}
+
+/**
+ * @brief Get the shadow masks of the neighbors of a chunk
+ * @param neighbors The shading of the neighboring chunks, indexed by the face they touch (nullptr outside the world)
+ * @return The shadow masks of the neighbors, indexed by the face they touch
+ * @note The sun reaches everything outside the world
+*/
+std::array<ChunkMask, FACE_COUNT> ChunkState_neighbors_shadow(const std::array<const ChunkState*, FACE_COUNT>& neighbors) {
+	std::array<ChunkMask, FACE_COUNT> nshadow;
+	for(int face = 0; face < FACE_COUNT; face++) {
+		if(neighbors[face]) {
+			nshadow[face] = neighbors[face]->shadow;
+		} else {
+			nshadow[face].fill(0);
+		}
+	}
+	return nshadow;
+}
+
+/**
+ * @brief Check whether the sun reaches a face of a block of a world
+ * @param world The world
+ * @param pos The position of the block
+ * @param face The face
+ * @param sun_vec The vector pointing towards the sun
+ * @return Whether the face is turned towards the sun and the block in front of it is not in the shadow
+*/
+bool World_face_sunlit(World* world, coords3 pos, Face face, coords3 sun_vec) {
+	if(!Face_faces_sun(face, sun_vec)) {
+		return false;
+	}
+	coords3 normal = Face_normal(face);
+	int x = pos.x + normal.x, y = pos.y + normal.y, z = pos.z + normal.z;
+	if(!World_contains(x, y, z)) {
+		return true;
+	}
+	return !(world->states[World_chunk_index(x / X_CHUNK_SIZE, y / Y_CHUNK_SIZE, z / Z_CHUNK_SIZE)]->shadow[z % Z_CHUNK_SIZE] & ChunkMask_bit(x % X_CHUNK_SIZE, y % Y_CHUNK_SIZE));
+}
+
+/**
+ * @brief Gather a row of blocks of a world from a mask of its chunks
+ * @param world The world
+ * @param shadow Whether to read the shadow masks of the chunks rather than their opacity masks
+ * @param y The y coordinate of the row
+ * @param z The z coordinate of the row
+ * @return The row, the bit of a block being its x coordinate
+*/
+ShadowRow World_mask_row(World* world, bool shadow, int y, int z) {
+	ShadowRow row = {};
+	int shift = y % Y_CHUNK_SIZE * X_CHUNK_SIZE;
+	for(int cx = 0; cx < X_CHUNK_COUNT; cx++) {
+		const ChunkMask& mask = shadow
+			? world->states[World_chunk_index(cx, y / Y_CHUNK_SIZE, z / Z_CHUNK_SIZE)]->shadow
+			: world->chunks[z / Z_CHUNK_SIZE][y / Y_CHUNK_SIZE][cx]->opacity;
+		uint64_t bar = mask[z % Z_CHUNK_SIZE] >> shift & 0xFF;
+		row[cx * X_CHUNK_SIZE / 64] |= bar << (cx * X_CHUNK_SIZE % 64);
+	}
+	return row;
+}
+
+/**
+ * @brief Shift a row of blocks by one block along x
+ * @param row The row
+ * @param dx The shift (-1, 0 or 1)
+ * @return The row whose block x is the block x + dx of the given row, nothing coming in from outside the world
+*/
+ShadowRow ShadowRow_shift(const ShadowRow& row, int dx) {
+	if(dx == 0) {
+		return row;
+	}
+	ShadowRow shifted;
+	for(int i = 0; i < SHADOW_ROW_WORDS; i++) {
+		if(dx > 0) {
+			shifted[i] = row[i] >> 1 | (i + 1 < SHADOW_ROW_WORDS ? row[i + 1] << 63 : 0);
+		} else {
+			shifted[i] = row[i] << 1 | (i > 0 ? row[i - 1] >> 63 : 0);
+		}
+	}
+	return shifted;
+}
+
+/**
+ * @brief Write a row of shadows into the chunks of a world
+ * @param shadows The sun shadows, flagging the chunks whose shadows changed
+ * @param world The world
+ * @param y The y coordinate of the row
+ * @param z The z coordinate of the row
+ * @param row The blocks of the row in the shadow
+ * @return Whether the shadows of the row changed
+*/
+bool SunShadows_write_row(SunShadows* shadows, World* world, int y, int z, const ShadowRow& row) {
+	int shift = y % Y_CHUNK_SIZE * X_CHUNK_SIZE;
+	bool changed = false;
+	for(int cx = 0; cx < X_CHUNK_COUNT; cx++) {
+		uint64_t bar = row[cx * X_CHUNK_SIZE / 64] >> (cx * X_CHUNK_SIZE % 64) & 0xFF;
+		uint64_t& word = world->states[World_chunk_index(cx, y / Y_CHUNK_SIZE, z / Z_CHUNK_SIZE)]->shadow[z % Z_CHUNK_SIZE];
+		if((word >> shift & 0xFF) != bar) {
+			shadows->tracker->changed[World_chunk_index(cx, y / Y_CHUNK_SIZE, z / Z_CHUNK_SIZE)][z % Z_CHUNK_SIZE] |= ((word >> shift & 0xFF) ^ bar) << shift;
+			word = (word & ~((uint64_t)0xFF << shift)) | bar << shift;
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+/**
+ * @brief Update the sun shadows of a world
+ * @param shadows The sun shadows
+ * @param world The world
+ * @param sun_vec The vector pointing towards the sun
+ * @note Only called by the world thread, once per tick after the edits and the streaming
+ * @note The layers are marched from the top down, a row of blocks being recomputed only when the row one step towards
+ * @note the sun changed its opacity or its shadows, so an edit only costs the rows downstream of it along the sun vector.
+ * @note A moved window, replaced chunks or a new sun direction cast the shadows of the whole world again.
+ * @note The chunks whose shadows changed get a new light version and are marked dirty along with the neighbors whose faces their changed border shades.
+*/
+void SunShadows_update(SunShadows* shadows, World* world, coords3 sun_vec) {
+	coords3 sun = Sun_direction(sun_vec);
+	bool full = shadows->sun.x != sun.x
+		|| shadows->sun.z != sun.z
+		|| ChunkTracker_moved(shadows->tracker, world);
+
+	// The rows whose opacity changed since the last update, indexed by y * MAX_Z_COORD + z
+	std::vector<bool> flipped(MAX_Y_COORD * MAX_Z_COORD, full);
+	for(int index = 0; index < WORLD_CHUNK_COUNT && !full; index++) {
+		int cx = index % X_CHUNK_COUNT;
+		int cy = index / X_CHUNK_COUNT % Y_CHUNK_COUNT;
+		int cz = index / (X_CHUNK_COUNT * Y_CHUNK_COUNT);
+		ChunkMask diff = ChunkTracker_flipped(shadows->tracker, world, cx, cy, cz);
+		for(int z = 0; z < Z_CHUNK_SIZE; z++) {
+			for(int y = 0; y < Y_CHUNK_SIZE; y++) {
+				if(diff[z] >> (y * X_CHUNK_SIZE) & 0xFF) {
+					flipped[(cy * Y_CHUNK_SIZE + y) * MAX_Z_COORD + cz * Z_CHUNK_SIZE + z] = true;
+				}
+			}
+		}
+	}
+
+	shadows->rows = 0;
+	// The rows of the layer above whose opacity or shadows changed, indexed by z
+	std::vector<bool> above(MAX_Z_COORD, false);
+	for(int y = MAX_Y_COORD - 1; y >= 0; y--) {
+		std::vector<bool> layer(MAX_Z_COORD, false);
+		for(int z = 0; z < MAX_Z_COORD; z++) {
+			bool changed = flipped[y * MAX_Z_COORD + z];
+			// The row one step towards the sun, whose blocks cast their shadows on this one
+			int source = z + sun.z;
+			bool inside = y + 1 < MAX_Y_COORD && source >= 0 && source < MAX_Z_COORD;
+			if(full || (inside && above[source])) {
+				ShadowRow row = {};
+				if(inside) {
+					ShadowRow opaque = World_mask_row(world, false, y + 1, source);
+					ShadowRow shadow = World_mask_row(world, true, y + 1, source);
+					for(int i = 0; i < SHADOW_ROW_WORDS; i++) {
+						row[i] = opaque[i] | shadow[i];
+					}
+					row = ShadowRow_shift(row, sun.x);
+				}
+				changed = SunShadows_write_row(shadows, world, y, z, row) || changed;
+				shadows->rows++;
+			}
+			layer[z] = changed;
+		}
+		above = layer;
+	}
+
+	shadows->updated = ChunkTracker_commit(shadows->tracker, world);
+	shadows->sun = sun;
+}
+
+#endif
@@ -0,0 +1,313 @@
+#ifndef __AQUICE_SDL3_SNAPSHOT_HPP__
+#define __AQUICE_SDL3_SNAPSHOT_HPP__
+
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "SDL.hpp"
+#include "world.hpp"
+#include "stream.hpp"
+
+/**
+ * @brief The magic number starting a snapshot file
+*/
+#define WORLD_SNAPSHOT_MAGIC 0x53525141
+/**
+ * @brief The version of the snapshot file format
+*/
+#define WORLD_SNAPSHOT_VERSION 6
+/**
+ * @brief The offset of the chunks in a snapshot file, a multiple of the page size
+*/
+#define WORLD_SNAPSHOT_CHUNKS_OFFSET 8192
+
+static_assert(std::is_trivially_copyable<Chunk>::value, "The chunks are stored in snapshots as they are in memory");
+static_assert(std::is_trivially_copyable<Palette>::value, "The palette is stored in snapshots as it is in memory");
+
+/**
+ * @brief The header of a snapshot file
+ * @note The chunks follow at WORLD_SNAPSHOT_CHUNKS_OFFSET, laid out exactly like Chunk, x first, then y, then z
+*/
+typedef struct WorldSnapshotHeader {
+	/**
+	 * @brief The magic number of the file
+	*/
+	uint32_t magic;
+	/**
+	 * @brief The version of the format
+	*/
+	uint32_t version;
+	/**
+	 * @brief The size of a chunk, which must match the one of the program
+	*/
+	uint32_t chunk_size;
+	/**
+	 * @brief The number of chunks along y, which must match the one of the program
+	*/
+	uint32_t y_chunk_count;
+	/**
+	 * @brief The position of the first chunk of the snapshot in the unbounded world, in chunks (y is 0)
+	*/
+	coords3 origin;
+	/**
+	 * @brief The number of chunks along x and z of the snapshot (y is Y_CHUNK_COUNT)
+	*/
+	coords3 size;
+	/**
+	 * @brief The colors of the blocks
+	*/
+	Palette palette;
+} WorldSnapshotHeader;
+
+static_assert(sizeof(WorldSnapshotHeader) <= WORLD_SNAPSHOT_CHUNKS_OFFSET, "The header of a snapshot must fit before its chunks");
+
+/**
+ * @brief A snapshot file mapped in memory, its chunks being used in place
+ * @note The mapping is private: writing to its chunks copies the pages written to, the file is never modified
+ * @note Only the first chunk starts on a page, the others are packed, so a page copied may hold parts of two or three chunks
+*/
+typedef struct WorldSnapshot {
+	/**
+	 * @brief The mapping of the file
+	*/
+	uint8_t* data;
+	/**
+	 * @brief The size of the file
+	*/
+	size_t size;
+#ifdef _WIN32
+	/**
+	 * @brief The mapping object of the file
+	*/
+	HANDLE mapping;
+#endif
+	/**
+	 * @brief The header of the file
+	*/
+	const WorldSnapshotHeader* header;
+	/**
+	 * @brief The chunks of the file
+	*/
+	Chunk* chunks;
+} WorldSnapshot;
+
+/**
+ * @brief Write a snapshot file
+ * @param path The path of the file
+ * @param origin The position of the first chunk of the snapshot in the unbounded world, in chunks (y is ignored)
+ * @param size The number of chunks along x and z of the snapshot (y is ignored)
+ * @param palette The palette the generator starts from
+ * @param generate The generator of the chunks, which may add colors to the palette
+ * @return Whether the file was written
+ * @note The chunks are generated and written one at a time, so the snapshot can be much bigger than the memory
+*/
+bool WorldSnapshot_write(std::string path, coords3 origin, coords3 size, Palette palette, ChunkGenerator generate) {
+	FILE* file = std::fopen(path.c_str(), "wb");
+	if(!file) {
+		return false;
+	}
+	bool written = std::fseek(file, WORLD_SNAPSHOT_CHUNKS_OFFSET, SEEK_SET) == 0;
+	Chunk* chunk = new Chunk();
+	for(int cz = 0; cz < size.z && written; cz++) {
+		for(int cy = 0; cy < Y_CHUNK_COUNT && written; cy++) {
+			for(int cx = 0; cx < size.x && written; cx++) {
+				*chunk = Chunk();
+				generate({origin.x + cx, cy, origin.z + cz}, chunk, &palette);
+				Chunk_update_masks(chunk, &palette);
+				written = std::fwrite(chunk, sizeof(Chunk), 1, file) == 1;
+			}
+		}
+	}
+	delete chunk;
+
+	// The header goes last, as the palette is only complete once every chunk is generated
+	WorldSnapshotHeader header = {};
+	header.magic = WORLD_SNAPSHOT_MAGIC;
+	header.version = WORLD_SNAPSHOT_VERSION;
+	header.chunk_size = sizeof(Chunk);
+	header.y_chunk_count = Y_CHUNK_COUNT;
+	header.origin = {origin.x, 0, origin.z};
+	header.size = {size.x, Y_CHUNK_COUNT, size.z};
+	header.palette = palette;
+	written = written
+		&& std::fseek(file, 0, SEEK_SET) == 0
+		&& std::fwrite(&header, sizeof(header), 1, file) == 1;
+	return std::fclose(file) == 0 && written;
+}
+
+/**
+ * @brief Write the chunks of a world to a snapshot file
+ * @param path The path of the file
+ * @param world The world
+ * @return Whether the file was written
+*/
+bool WorldSnapshot_write_world(std::string path, World* world) {
+	return WorldSnapshot_write(path, world->origin, {X_CHUNK_COUNT, Y_CHUNK_COUNT, Z_CHUNK_COUNT}, world->palette, [world](coords3 pos, Chunk* chunk, Palette*) {
+		*chunk = *World_get_chunk(world, pos.x - world->origin.x, pos.y, pos.z - world->origin.z);
+	});
+}
+
+/**
+ * @brief Map a snapshot file in memory
+ * @param path The path of the file
+ * @return The snapshot pointer, or nullptr if the file does not exist or does not match the program
+ * @note Nothing is read but the header, the pages of the chunks are faulted in when they are first used
+*/
+WorldSnapshot* WorldSnapshot_open(std::string path) {
+	uint8_t* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(file == INVALID_HANDLE_VALUE) {
+		return nullptr;
+	}
+	LARGE_INTEGER file_size;
+	HANDLE mapping = nullptr;
+	if(GetFileSizeEx(file, &file_size) && file_size.QuadPart >= WORLD_SNAPSHOT_CHUNKS_OFFSET) {
+		size = (size_t)file_size.QuadPart;
+		mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	}
+	CloseHandle(file);
+	if(!mapping) {
+		return nullptr;
+	}
+	data = (uint8_t*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	if(!data) {
+		CloseHandle(mapping);
+		return nullptr;
+	}
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if(file < 0) {
+		return nullptr;
+	}
+	struct stat info;
+	if(fstat(file, &info) == 0 && info.st_size >= WORLD_SNAPSHOT_CHUNKS_OFFSET) {
+		size = (size_t)info.st_size;
+		void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+		data = mapped == MAP_FAILED ? nullptr : (uint8_t*)mapped;
+	}
+	close(file);
+	if(!data) {
+		return nullptr;
+	}
+	// The camera visits the chunks in no particular order of the file
+	madvise(data, size, MADV_RANDOM);
+#endif
+
+	WorldSnapshot* snapshot = new WorldSnapshot();
+	snapshot->data = data;
+	snapshot->size = size;
+#ifdef _WIN32
+	snapshot->mapping = mapping;
+#endif
+	snapshot->header = (const WorldSnapshotHeader*)data;
+	snapshot->chunks = (Chunk*)(data + WORLD_SNAPSHOT_CHUNKS_OFFSET);
+
+	const WorldSnapshotHeader* header = snapshot->header;
+	bool valid = header->magic == WORLD_SNAPSHOT_MAGIC
+		&& header->version == WORLD_SNAPSHOT_VERSION
+		&& header->chunk_size == sizeof(Chunk)
+		&& header->y_chunk_count == Y_CHUNK_COUNT
+		&& header->size.x >= 0 && header->size.z >= 0
+		&& header->palette.count >= 1 && header->palette.count <= PALETTE_SIZE
+		&& (size - WORLD_SNAPSHOT_CHUNKS_OFFSET) / sizeof(Chunk) >= (size_t)header->size.x * Y_CHUNK_COUNT * header->size.z;
+	if(!valid) {
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+		CloseHandle(mapping);
+#else
+		munmap(data, size);
+#endif
+		delete snapshot;
+		return nullptr;
+	}
+	return snapshot;
+}
+
+/**
+ * @brief Get a chunk of a snapshot, in place
+ * @param snapshot The snapshot
+ * @param pos The position of the chunk in the unbounded world, in chunks
+ * @return The chunk, or nullptr if it is outside the snapshot
+*/
+Chunk* WorldSnapshot_get_chunk(WorldSnapshot* snapshot, coords3 pos) {
+	const WorldSnapshotHeader* header = snapshot->header;
+	int cx = pos.x - header->origin.x;
+	int cz = pos.z - header->origin.z;
+	if(cx < 0 || pos.y < 0 || cz < 0 || cx >= header->size.x || pos.y >= Y_CHUNK_COUNT || cz >= header->size.z) {
+		return nullptr;
+	}
+	return &snapshot->chunks[cx + (size_t)header->size.x * (pos.y + Y_CHUNK_COUNT * (size_t)cz)];
+}
+
+/**
+ * @brief Point the chunks of a world at the chunks of a snapshot, with no copy nor parsing
+ * @param world The world, whose window is kept where it is
+ * @param snapshot The snapshot, which must outlive the use of its chunks by the world
+ * @note The chunks outside the snapshot are the air chunks of the world storage, and every chunk is marked dirty
+ * @note Editing a chunk of the snapshot only copies its pages, the file is left untouched, and its shading stays in the world
+ * @note A chunk streamer drops these chunks on its first update, give it WorldSnapshot_mapper instead to stream a snapshot
+*/
+void World_map_snapshot(World* world, WorldSnapshot* snapshot) {
+	uint32_t version = world->palette.version;
+	world->palette = snapshot->header->palette;
+	world->palette.version = version + 1;
+	world->storage.assign(WORLD_CHUNK_COUNT, Chunk());
+	world->dirty.clear();
+	world->marked.fill(false);
+	for(int cz = 0; cz < Z_CHUNK_COUNT; cz++) {
+		for(int cy = 0; cy < Y_CHUNK_COUNT; cy++) {
+			for(int cx = 0; cx < X_CHUNK_COUNT; cx++) {
+				Chunk* chunk = WorldSnapshot_get_chunk(snapshot, {world->origin.x + cx, cy, world->origin.z + cz});
+				world->chunks[cz][cy][cx] = chunk ? chunk : &world->storage[World_chunk_index(cx, cy, cz)];
+				World_mark_dirty(world, cx, cy, cz);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Get the chunk mapper of a snapshot, for a chunk streamer over a snapshot bigger than the world
+ * @param snapshot The snapshot, which must outlive the chunk streamer
+ * @return The chunk mapper, handing out the chunks inside the snapshot in place
+ * @note The palette of the world must be the one of the snapshot
+ * @note Editing a chunk of the snapshot only copies its pages, the chunk being saved by the streamer and read back from storage afterwards
+*/
+ChunkMapper WorldSnapshot_mapper(WorldSnapshot* snapshot) {
+	return [snapshot](coords3 pos) {
+		return WorldSnapshot_get_chunk(snapshot, pos);
+	};
+}
+
+/**
+ * @brief Unmap a snapshot file
+ * @param snapshot The snapshot pointer
+ * @note The worlds using its chunks must not be used anymore
+*/
+void WorldSnapshot_free(WorldSnapshot* snapshot) {
+#ifdef _WIN32
+	UnmapViewOfFile(snapshot->data);
+	CloseHandle(snapshot->mapping);
+#else
+	munmap(snapshot->data, snapshot->size);
+#endif
+	delete snapshot;
+}
+
+#endif
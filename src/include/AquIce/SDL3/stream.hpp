@@ -0,0 +1,589 @@
+#ifndef __AQUICE_SDL3_STREAM_HPP__
+#define __AQUICE_SDL3_STREAM_HPP__
+
+#define CHUNK_GENERATION_BATCH 32
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "SDL.hpp"
+#include "world.hpp"
+#include "../utils/jobs.hpp"
+
+/**
+ * @brief A function filling a chunk of an unbounded world from nothing
+ * @note Called with the position of the chunk (in chunks), the chunk to fill (air) and the palette of the world
+ * @note A chunk streamer calls it from its workers, the palette must then only be read
+*/
+typedef std::function<void(coords3, Chunk*, Palette*)> ChunkGenerator;
+/**
+ * @brief The states of the load of a chunk from storage
+*/
+typedef enum ChunkLoadState {
+	CHUNK_LOAD_MISSING,
+	CHUNK_LOAD_DONE,
+	CHUNK_LOAD_PENDING
+} ChunkLoadState;
+
+/**
+ * @brief A function reading a chunk of an unbounded world back from storage
+ * @note Called with the position of the chunk (in chunks) and the chunk to fill, returns whether the chunk was stored,
+ * @note or CHUNK_LOAD_PENDING while it is read in the background, the function then being called again on the next updates
+ * @note Only the blocks need to be read, the masks are recomputed from them
+*/
+typedef std::function<ChunkLoadState(coords3, Chunk*)> ChunkLoader;
+/**
+ * @brief A function writing a chunk of an unbounded world to storage
+ * @note Called with the position of the chunk (in chunks) and the chunk
+*/
+typedef std::function<void(coords3, const Chunk*)> ChunkSaver;
+/**
+ * @brief A function handing out a chunk of an unbounded world in place, with its masks up to date
+ * @note Called with the position of the chunk (in chunks), returns the chunk, which must outlive the chunk streamer, or nullptr when it has none
+*/
+typedef std::function<Chunk*(coords3)> ChunkMapper;
+
+/**
+ * @brief A chunk held in memory by a chunk streamer
+*/
+typedef struct ChunkCacheEntry {
+	/**
+	 * @brief The position of the chunk, in chunks
+	*/
+	coords3 pos;
+	/**
+	 * @brief The chunk
+	*/
+	Chunk* chunk;
+	/**
+	 * @brief The shading of the chunk
+	*/
+	ChunkState* state;
+	/**
+	 * @brief The version of the chunk when it was materialized or last saved
+	*/
+	uint32_t saved_version;
+	/**
+	 * @brief The last update the chunk was needed by
+	*/
+	uint64_t update;
+	/**
+	 * @brief Whether the chunk is still being loaded, holding only air until then
+	*/
+	bool loading;
+	/**
+	 * @brief Whether the chunk was handed out in place by the mapper, the streamer not owning it
+	*/
+	bool mapped;
+} ChunkCacheEntry;
+
+/**
+ * @brief A chunk generated in the background
+*/
+typedef struct ChunkGeneration {
+	/**
+	 * @brief The position of the chunk, in chunks
+	*/
+	coords3 pos;
+	/**
+	 * @brief The job generating the chunk and the others of its batch (nullptr until submitted)
+	*/
+	JobHandle job;
+	/**
+	 * @brief Whether the chunk is generated
+	*/
+	std::atomic<bool> done;
+	/**
+	 * @brief The chunk generated, its masks not being computed
+	*/
+	Chunk chunk;
+} ChunkGeneration;
+
+/**
+ * @brief Hash the position of a chunk
+*/
+typedef struct ChunkPosHash {
+	size_t operator()(const coords3& pos) const {
+		return std::hash<uint64_t>()((uint64_t)(uint32_t)pos.x * 0x9E3779B97F4A7C15ULL ^ (uint64_t)(uint32_t)pos.z << 8 ^ (uint64_t)(uint32_t)pos.y);
+	}
+} ChunkPosHash;
+
+/**
+ * @brief Compare the positions of two chunks
+*/
+typedef struct ChunkPosEqual {
+	bool operator()(const coords3& a, const coords3& b) const {
+		return a.x == b.x && a.y == b.y && a.z == b.z;
+	}
+} ChunkPosEqual;
+
+/**
+ * @brief The streamer of the chunks of an unbounded world around the view
+ * @note The world is a window on the unbounded world, recentered on the view when it gets close to its border.
+ * @note The chunks of the window and of the view with a margin are kept in memory, the others being evicted from the
+ * @note least recently needed one when over the memory budget, and materialized again from storage or the generator.
+ * @note A chunk loaded in the background is air until its load finishes, it is then filled in by the next update.
+ * @note A chunk is read from storage first, then handed out in place by the mapper, then generated in the background.
+*/
+typedef struct ChunkStreamer {
+	/**
+	 * @brief The chunks in memory, from the most recently needed one
+	*/
+	std::list<ChunkCacheEntry> lru;
+	/**
+	 * @brief The chunks in memory, by position
+	*/
+	std::unordered_map<coords3, std::list<ChunkCacheEntry>::iterator, ChunkPosHash, ChunkPosEqual> entries;
+	/**
+	 * @brief The maximum memory used by the chunks, in bytes
+	 * @note The chunks needed by the current update are never evicted, even over the budget
+	*/
+	size_t budget;
+	/**
+	 * @brief The number of chunks kept around the view
+	*/
+	int margin;
+	/**
+	 * @brief The current update
+	*/
+	uint64_t update;
+	/**
+	 * @brief The job system the chunks are generated on (nullptr to generate them on the calling thread)
+	*/
+	JobSystem* jobs;
+	/**
+	 * @brief The generator of the chunks never stored
+	*/
+	ChunkGenerator generate;
+	/**
+	 * @brief The chunks being generated, by position, until they are collected
+	*/
+	std::unordered_map<coords3, std::shared_ptr<ChunkGeneration>, ChunkPosHash, ChunkPosEqual> generating;
+	/**
+	 * @brief The chunks to generate not submitted yet, submitted in batches at the end of the update
+	*/
+	std::vector<std::shared_ptr<ChunkGeneration>> queued;
+	/**
+	 * @brief The reader of the stored chunks (nullptr for none)
+	*/
+	ChunkLoader load;
+	/**
+	 * @brief The positions of the chunks still being loaded, in chunks
+	*/
+	std::vector<coords3> loading;
+	/**
+	 * @brief The writer of the evicted chunks edited since they were materialized (nullptr for none)
+	 * @note Without it, the edited chunks are never evicted
+	*/
+	ChunkSaver save;
+	/**
+	 * @brief The source of the chunks handed out in place (nullptr for none)
+	*/
+	ChunkMapper map;
+	/**
+	 * @brief The number of chunks in memory handed out by the mapper
+	*/
+	size_t mapped;
+} ChunkStreamer;
+
+/**
+ * @brief Create a new chunk streamer
+ * @param jobs The job system the chunks are generated on (nullptr to generate them on the calling thread)
+ * @param budget The maximum memory used by the chunks, in bytes
+ * @param margin The number of chunks kept around the view
+ * @param generate The generator of the chunks never stored
+ * @param load The reader of the stored chunks (nullptr for none)
+ * @param save The writer of the evicted edited chunks (nullptr for none)
+ * @param map The source of the chunks handed out in place, such as the chunks of a snapshot (nullptr for none)
+ * @return The chunk streamer pointer
+*/
+ChunkStreamer* ChunkStreamer_new(JobSystem* jobs, size_t budget, int margin, ChunkGenerator generate, ChunkLoader load = nullptr, ChunkSaver save = nullptr, ChunkMapper map = nullptr) {
+	ChunkStreamer* streamer = new ChunkStreamer();
+	streamer->budget = budget;
+	streamer->margin = margin;
+	streamer->update = 0;
+	streamer->jobs = jobs;
+	streamer->generate = generate;
+	streamer->load = load;
+	streamer->save = save;
+	streamer->map = map;
+	streamer->mapped = 0;
+	return streamer;
+}
+
+/**
+ * @brief Get the memory used by the chunks of a chunk streamer
+ * @param streamer The chunk streamer
+ * @return The memory used, in bytes
+ * @note The chunks handed out by the mapper are not counted, only their shading
+*/
+size_t ChunkStreamer_memory(ChunkStreamer* streamer) {
+	return streamer->lru.size() * sizeof(ChunkState) + (streamer->lru.size() - streamer->mapped) * sizeof(Chunk);
+}
+
+/**
+ * @brief Fill a chunk from storage, the mapper or the generator
+ * @param streamer The chunk streamer
+ * @param palette The palette of the world
+ * @param pos The position of the chunk, in chunks
+ * @param chunk The chunk to fill, holding only air
+ * @param mapped The chunk handed out in place by the mapper to set, nullptr when the chunk was filled instead
+ * @return Whether the chunk is still being loaded or generated, staying air until then
+ * @note Called again on the next updates until it is done, a chunk being generated is then collected
+*/
+bool ChunkStreamer_materialize(ChunkStreamer* streamer, Palette* palette, coords3 pos, Chunk* chunk, Chunk** mapped) {
+	*mapped = nullptr;
+	auto found = streamer->generating.find(pos);
+	if(found != streamer->generating.end()) {
+		if(!found->second->done.load(std::memory_order_acquire)) {
+			return true;
+		}
+		chunk->blocks = found->second->chunk.blocks;
+		streamer->generating.erase(found);
+		return false;
+	}
+
+	ChunkLoadState state = streamer->load ? streamer->load(pos, chunk) : CHUNK_LOAD_MISSING;
+	if(state == CHUNK_LOAD_PENDING) {
+		return true;
+	}
+	if(state == CHUNK_LOAD_MISSING) {
+		*chunk = Chunk();
+		*mapped = streamer->map ? streamer->map(pos) : nullptr;
+		if(!*mapped && pos.y >= 0 && pos.y < Y_CHUNK_COUNT && streamer->generate) {
+			if(!streamer->jobs) {
+				streamer->generate(pos, chunk, palette);
+				return false;
+			}
+			auto generation = std::make_shared<ChunkGeneration>();
+			generation->pos = pos;
+			generation->done.store(false, std::memory_order_relaxed);
+			streamer->generating[pos] = generation;
+			streamer->queued.push_back(generation);
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Get a chunk of the unbounded world, materializing it if needed
+ * @param streamer The chunk streamer
+ * @param palette The palette of the world
+ * @param pos The position of the chunk, in chunks
+ * @return The entry of the chunk, needed by the current update
+ * @note A chunk loaded in the background is returned as air, ChunkStreamer_update fills it in later
+*/
+ChunkCacheEntry* ChunkStreamer_get(ChunkStreamer* streamer, Palette* palette, coords3 pos) {
+	auto found = streamer->entries.find(pos);
+	if(found != streamer->entries.end()) {
+		streamer->lru.splice(streamer->lru.begin(), streamer->lru, found->second);
+		found->second->update = streamer->update;
+		return &*found->second;
+	}
+
+	Chunk* chunk = new Chunk();
+	Chunk* mapped = nullptr;
+	bool loading = ChunkStreamer_materialize(streamer, palette, pos, chunk, &mapped);
+	if(loading) {
+		streamer->loading.push_back(pos);
+	}
+	if(mapped) {
+		// The chunk is never written to but by edits, so its pages are only copied then
+		delete chunk;
+		chunk = mapped;
+		streamer->mapped++;
+	} else {
+		Chunk_update_masks(chunk, palette);
+	}
+	streamer->lru.push_front({pos, chunk, new ChunkState(), chunk->version, streamer->update, loading, mapped != nullptr});
+	streamer->entries[pos] = streamer->lru.begin();
+	return &streamer->lru.front();
+}
+
+/**
+ * @brief Fill in the chunks of a chunk streamer whose load finished
+ * @param streamer The chunk streamer
+ * @param world The world
+ * @note The chunks of the world window are changed through World_chunk_changed, so they and their neighbors are meshed again,
+ * @note a chunk handed out by the mapper replacing the air one in the window
+ * @note The blocks read replace the air the chunk held, edits made to it meanwhile are lost
+*/
+void ChunkStreamer_finish_loads(ChunkStreamer* streamer, World* world) {
+	std::vector<coords3> loading;
+	for(coords3 pos : streamer->loading) {
+		ChunkCacheEntry& entry = *streamer->entries[pos];
+		Chunk loaded = Chunk();
+		Chunk* mapped = nullptr;
+		if(ChunkStreamer_materialize(streamer, &world->palette, pos, &loaded, &mapped)) {
+			loading.push_back(pos);
+			continue;
+		}
+		int cx = pos.x - world->origin.x;
+		int cz = pos.z - world->origin.z;
+		bool inside = cx >= 0 && cx < X_CHUNK_COUNT && pos.y >= 0 && pos.y < Y_CHUNK_COUNT && cz >= 0 && cz < Z_CHUNK_COUNT;
+		if(mapped) {
+			delete entry.chunk;
+			entry.chunk = mapped;
+			entry.mapped = true;
+			streamer->mapped++;
+			if(inside) {
+				world->chunks[cz][pos.y][cx] = mapped;
+				World_mark_dirty(world, cx, pos.y, cz);
+				World_mark_dirty_around(world, cx, pos.y, cz, mapped->opacity, true);
+			}
+		} else if(inside) {
+			entry.chunk->blocks = loaded.blocks;
+			World_chunk_changed(world, cx, pos.y, cz);
+		} else {
+			entry.chunk->blocks = loaded.blocks;
+			Chunk_update_masks(entry.chunk, &world->palette);
+			entry.chunk->version++;
+		}
+		entry.saved_version = entry.chunk->version;
+		entry.loading = false;
+	}
+	streamer->loading = loading;
+}
+
+/**
+ * @brief Evict the least recently needed chunks of a chunk streamer down to its memory budget
+ * @param streamer The chunk streamer
+ * @note The edited chunks are saved first, or kept when there is no saver, and the chunks being loaded are kept
+*/
+void ChunkStreamer_evict(ChunkStreamer* streamer) {
+	auto entry = streamer->lru.end();
+	while(ChunkStreamer_memory(streamer) > streamer->budget && entry != streamer->lru.begin()) {
+		entry--;
+		if(entry->update == streamer->update) {
+			// The chunks needed by the current update are all at the front
+			break;
+		}
+		if(entry->loading) {
+			continue;
+		}
+		if(entry->chunk->version != entry->saved_version) {
+			if(!streamer->save) {
+				continue;
+			}
+			streamer->save(entry->pos, entry->chunk);
+		}
+		if(entry->mapped) {
+			streamer->mapped--;
+		} else {
+			delete entry->chunk;
+		}
+		delete entry->state;
+		streamer->entries.erase(entry->pos);
+		entry = streamer->lru.erase(entry);
+	}
+}
+
+/**
+ * @brief Submit the chunks queued for generation to the job system
+ * @param streamer The chunk streamer
+ * @param palette The palette of the world
+ * @note The chunks are generated by batches of CHUNK_GENERATION_BATCH, a chunk alone being too small a job
+*/
+void ChunkStreamer_submit_generations(ChunkStreamer* streamer, Palette* palette) {
+	for(size_t first = 0; first < streamer->queued.size(); first += CHUNK_GENERATION_BATCH) {
+		size_t last = std::min(first + CHUNK_GENERATION_BATCH, streamer->queued.size());
+		std::vector<std::shared_ptr<ChunkGeneration>> batch(
+			streamer->queued.begin() + first,
+			streamer->queued.begin() + last
+		);
+		ChunkGenerator generate = streamer->generate;
+		JobHandle job = JobSystem_submit(streamer->jobs, [generate, palette, batch] {
+			for(const auto& generation : batch) {
+				generate(generation->pos, &generation->chunk, palette);
+				generation->done.store(true, std::memory_order_release);
+			}
+		});
+		for(const auto& generation : batch) {
+			generation->job = job;
+		}
+	}
+	streamer->queued.clear();
+}
+
+/**
+ * @brief Check whether a chunk of a chunk streamer is still being loaded or generated
+ * @param streamer The chunk streamer
+ * @param pos The position of the chunk, in chunks
+ * @return Whether the chunk is in memory and still being loaded, holding only air until then
+*/
+bool ChunkStreamer_is_loading(ChunkStreamer* streamer, coords3 pos) {
+	auto found = streamer->entries.find(pos);
+	return found != streamer->entries.end() && found->second->loading;
+}
+
+/**
+ * @brief Mark a chunk of a chunk streamer as saved
+ * @param streamer The chunk streamer
+ * @param pos The position of the chunk, in chunks
+ * @note For the chunks saved outside of the streamer, so it does not save them again on eviction until they are edited again
+*/
+void ChunkStreamer_mark_saved(ChunkStreamer* streamer, coords3 pos) {
+	auto found = streamer->entries.find(pos);
+	if(found != streamer->entries.end() && !found->second->loading) {
+		found->second->saved_version = found->second->chunk->version;
+	}
+}
+
+/**
+ * @brief Get the range of blocks of the unbounded world a view may show
+ * @param world The world
+ * @param config The SDL3 configuration
+ * @param view The part of the 2D plane viewed
+ * @param min The lowest x and z coordinates to fill, in blocks of the unbounded world
+ * @param max The highest x and z coordinates to fill, in blocks of the unbounded world
+ * @note A point of the view shows the blocks along the camera vector, from the bottom to the top of the world
+*/
+void ChunkStreamer_view_range(World* world, SDL3_Config* config, SDL_Rect* view, coords* min, coords* max) {
+	int sx = config->cam_vec.x < 0 ? -1 : 1;
+	int sy = config->cam_vec.y < 0 ? -1 : 1;
+	int sz = config->cam_vec.z < 0 ? -1 : 1;
+	double min_x = INFINITY, max_x = -INFINITY, min_z = INFINITY, max_z = -INFINITY;
+	for(int corner = 0; corner < 4; corner++) {
+		double u = view->x + (corner & 1 ? view->w : 0) - config->origin.x;
+		double v = view->y + (corner & 2 ? view->h : 0) - config->origin.y;
+		vec3 point = get_3d_point(u, v, config);
+		for(int height : {0, MAX_Y_COORD}) {
+			double x = point.x + height * sy * sx;
+			double z = point.z + height * sy * sz;
+			min_x = std::min(min_x, x);
+			max_x = std::max(max_x, x);
+			min_z = std::min(min_z, z);
+			max_z = std::max(max_z, z);
+		}
+	}
+	*min = {(int)std::floor(min_x) + world->origin.x * X_CHUNK_SIZE, (int)std::floor(min_z) + world->origin.z * Z_CHUNK_SIZE};
+	*max = {(int)std::ceil(max_x) + world->origin.x * X_CHUNK_SIZE, (int)std::ceil(max_z) + world->origin.z * Z_CHUNK_SIZE};
+}
+
+/**
+ * @brief Floor divide two integers
+ * @param a The dividend
+ * @param b The divisor (positive)
+ * @return The quotient, rounded down
+*/
+int floor_div(int a, int b) {
+	return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+/**
+ * @brief Stream the chunks of the world around a view
+ * @param streamer The chunk streamer
+ * @param world The world, whose chunks and their shading become owned by the streamer
+ * @param config The SDL3 configuration, whose origin is moved along with the world so the view shows the same blocks
+ * @param view The part of the 2D plane viewed
+ * @return Whether the chunks of the world were replaced, they are then all marked dirty (a chunk mesher drops the meshes of the old window)
+ * @note The world is recentered when the center of the view is a quarter of the world away from its center
+ * @note A world still holding its own chunks is taken over on the first update: they are dropped, the window being filled from storage and the generator
+ * @note The chunks whose background load or generation finished since the last update are filled in
+*/
+bool ChunkStreamer_update(ChunkStreamer* streamer, World* world, SDL3_Config* config, SDL_Rect* view) {
+	streamer->update++;
+	coords min, max;
+	ChunkStreamer_view_range(world, config, view, &min, &max);
+	int center_x = floor_div((min.x + max.x) / 2, X_CHUNK_SIZE);
+	int center_z = floor_div((min.y + max.y) / 2, Z_CHUNK_SIZE);
+
+	bool taken = !world->storage.empty();
+	if(taken) {
+		// Its chunks are replaced by the ones of the streamer below
+		world->storage.clear();
+		world->storage.shrink_to_fit();
+		world->state_storage.clear();
+		world->state_storage.shrink_to_fit();
+	}
+	bool moved = std::abs(center_x - (world->origin.x + X_CHUNK_COUNT / 2)) > X_CHUNK_COUNT / 4
+		|| std::abs(center_z - (world->origin.z + Z_CHUNK_COUNT / 2)) > Z_CHUNK_COUNT / 4;
+	if(moved) {
+		coords3 origin = {center_x - X_CHUNK_COUNT / 2, 0, center_z - Z_CHUNK_COUNT / 2};
+		coords offset = get_2d_offset({
+			(origin.x - world->origin.x) * X_CHUNK_SIZE,
+			0,
+			(origin.z - world->origin.z) * Z_CHUNK_SIZE
+		}, config);
+		config->origin.x += offset.x;
+		config->origin.y += offset.y;
+		world->origin = origin;
+	}
+
+	// The chunks of the window, then the ones around the view
+	for(int cz = 0; cz < Z_CHUNK_COUNT; cz++) {
+		for(int cy = 0; cy < Y_CHUNK_COUNT; cy++) {
+			for(int cx = 0; cx < X_CHUNK_COUNT; cx++) {
+				ChunkCacheEntry* entry = ChunkStreamer_get(
+					streamer,
+					&world->palette,
+					{world->origin.x + cx, cy, world->origin.z + cz}
+				);
+				world->chunks[cz][cy][cx] = entry->chunk;
+				world->states[World_chunk_index(cx, cy, cz)] = entry->state;
+			}
+		}
+	}
+	// Only the window is drawn, so the view is clipped to it before adding the margin
+	int margin = streamer->margin;
+	int min_cx = std::max(floor_div(min.x, X_CHUNK_SIZE), world->origin.x) - margin;
+	int max_cx = std::min(floor_div(max.x, X_CHUNK_SIZE), world->origin.x + X_CHUNK_COUNT - 1) + margin;
+	int min_cz = std::max(floor_div(min.y, Z_CHUNK_SIZE), world->origin.z) - margin;
+	int max_cz = std::min(floor_div(max.y, Z_CHUNK_SIZE), world->origin.z + Z_CHUNK_COUNT - 1) + margin;
+	for(int cz = min_cz; cz <= max_cz; cz++) {
+		for(int cx = min_cx; cx <= max_cx; cx++) {
+			for(int cy = 0; cy < Y_CHUNK_COUNT; cy++) {
+				ChunkStreamer_get(streamer, &world->palette, {cx, cy, cz});
+			}
+		}
+	}
+	ChunkStreamer_submit_generations(streamer, &world->palette);
+	ChunkStreamer_finish_loads(streamer, world);
+	ChunkStreamer_evict(streamer);
+
+	if(moved || taken) {
+		world->dirty.clear();
+		world->marked.fill(false);
+		for(int cz = 0; cz < Z_CHUNK_COUNT; cz++) {
+			for(int cy = 0; cy < Y_CHUNK_COUNT; cy++) {
+				for(int cx = 0; cx < X_CHUNK_COUNT; cx++) {
+					World_mark_dirty(world, cx, cy, cz);
+				}
+			}
+		}
+	}
+	return moved || taken;
+}
+
+/**
+ * @brief Free a chunk streamer and its chunks
+ * @param streamer The chunk streamer pointer
+ * @note The chunks being generated are waited for, the edited chunks are saved (but the ones still being loaded), the worlds streamed must not be used anymore
+*/
+void ChunkStreamer_free(ChunkStreamer* streamer) {
+	for(auto& generation : streamer->generating) {
+		if(generation.second->job) {
+			JobSystem_wait(streamer->jobs, generation.second->job);
+		}
+	}
+	for(auto& entry : streamer->lru) {
+		if(entry.chunk->version != entry.saved_version && !entry.loading && streamer->save) {
+			streamer->save(entry.pos, entry.chunk);
+		}
+		if(!entry.mapped) {
+			delete entry.chunk;
+		}
+		delete entry.state;
+	}
+	delete streamer;
+}
+
+#endif
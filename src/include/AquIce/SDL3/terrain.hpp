@@ -0,0 +1,260 @@
+#ifndef __AQUICE_SDL3_TERRAIN_HPP__
+#define __AQUICE_SDL3_TERRAIN_HPP__
+
+#include <array>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <cstdint>
+
+#include "SDL.hpp"
+#include "world.hpp"
+#include "stream.hpp"
+#include "../utils/noise.hpp"
+#include "../utils/jobs.hpp"
+
+/**
+ * @brief A seeded heightmap terrain generator
+ * @note The height of a column only depends on the seed and its position, so the terrain is the same whatever
+ * @note the order and the threads its chunks are generated on
+*/
+typedef struct TerrainGenerator {
+	/**
+	 * @brief The seed of the noise
+	*/
+	uint32_t seed;
+	/**
+	 * @brief The number of blocks per noise cell of the first octave
+	*/
+	float scale;
+	/**
+	 * @brief The number of octaves of the noise
+	*/
+	int octaves;
+	/**
+	 * @brief The height of the ground where the noise is the lowest
+	*/
+	int base_height;
+	/**
+	 * @brief The height difference between the lowest and the highest ground
+	*/
+	int amplitude;
+	/**
+	 * @brief The height of the surface of the water, filling the ground below it
+	*/
+	int sea_level;
+	/**
+	 * @brief The number of dirt blocks under the surface of the ground
+	*/
+	int dirt_depth;
+	/**
+	 * @brief The colors of the blocks
+	*/
+	RGBA grass, dirt, stone, sand, water;
+} TerrainGenerator;
+
+/**
+ * @brief The blocks of a terrain, in the palette of a world
+*/
+typedef struct TerrainBlocks {
+	Block grass, dirt, stone, sand, water;
+} TerrainBlocks;
+
+/**
+ * @brief The heights of the ground of the columns of a chunk column, indexed by x + z * X_CHUNK_SIZE
+*/
+typedef std::array<int, X_CHUNK_SIZE * Z_CHUNK_SIZE> TerrainHeights;
+
+/**
+ * @brief The number of chunk columns whose heights a chunk generator of a terrain keeps
+*/
+#define TERRAIN_HEIGHTS_CACHE 1024
+
+/**
+ * @brief The heights of the chunk columns last generated, shared by the workers generating their chunks
+*/
+typedef struct TerrainHeightsCache {
+	/**
+	 * @brief The lock of the heights
+	*/
+	std::mutex lock;
+	/**
+	 * @brief The heights of the chunk columns, by position (y is 0), forgotten all at once past TERRAIN_HEIGHTS_CACHE
+	*/
+	std::unordered_map<coords3, TerrainHeights, ChunkPosHash, ChunkPosEqual> heights;
+} TerrainHeightsCache;
+
+/**
+ * @brief Create a new terrain generator with rolling hills and lakes
+ * @param seed The seed of the noise
+ * @return The terrain generator
+*/
+TerrainGenerator TerrainGenerator_new(uint32_t seed) {
+	TerrainGenerator terrain;
+	terrain.seed = seed;
+	terrain.scale = 48;
+	terrain.octaves = 4;
+	terrain.base_height = 2;
+	terrain.amplitude = MAX_Y_COORD / 2;
+	terrain.sea_level = MAX_Y_COORD / 4;
+	terrain.dirt_depth = 3;
+	terrain.grass = {100, 160, 80, 255};
+	terrain.dirt = {130, 95, 60, 255};
+	terrain.stone = {125, 125, 130, 255};
+	terrain.sand = {215, 200, 140, 255};
+	terrain.water = {60, 110, 200, 160};
+	return terrain;
+}
+
+/**
+ * @brief Get the blocks of a terrain in a palette, adding their colors to it if needed
+ * @param terrain The terrain generator
+ * @param palette The palette
+ * @param blocks The blocks to fill
+ * @return Whether every color of the terrain is in the palette, the missing ones being air
+ * @note Call it before generating chunks in parallel, the palette is then only read
+*/
+bool TerrainGenerator_blocks(const TerrainGenerator* terrain, Palette* palette, TerrainBlocks* blocks) {
+	bool grass = Palette_block(palette, terrain->grass, &blocks->grass);
+	bool dirt = Palette_block(palette, terrain->dirt, &blocks->dirt);
+	bool stone = Palette_block(palette, terrain->stone, &blocks->stone);
+	bool sand = Palette_block(palette, terrain->sand, &blocks->sand);
+	bool water = Palette_block(palette, terrain->water, &blocks->water);
+	return grass && dirt && stone && sand && water;
+}
+
+/**
+ * @brief Compute the heights of the ground of a chunk column
+ * @param terrain The terrain generator
+ * @param cx The x coordinate of the chunk column in the unbounded world, in chunks
+ * @param cz The z coordinate of the chunk column in the unbounded world, in chunks
+ * @param heights The heights to fill, each one being the y coordinate of the highest ground block
+*/
+void TerrainGenerator_heights(const TerrainGenerator* terrain, int cx, int cz, TerrainHeights* heights) {
+	std::array<float, X_CHUNK_SIZE * Z_CHUNK_SIZE> x, z, noise;
+	for(int i = 0; i < X_CHUNK_SIZE * Z_CHUNK_SIZE; i++) {
+		x[i] = (float)(cx * X_CHUNK_SIZE + i % X_CHUNK_SIZE) / terrain->scale;
+		z[i] = (float)(cz * Z_CHUNK_SIZE + i / X_CHUNK_SIZE) / terrain->scale;
+	}
+	Noise_fractal(terrain->seed, x.data(), z.data(), noise.data(), X_CHUNK_SIZE * Z_CHUNK_SIZE, terrain->octaves);
+	for(int i = 0; i < X_CHUNK_SIZE * Z_CHUNK_SIZE; i++) {
+		(*heights)[i] = std::min(terrain->base_height + (int)(noise[i] * terrain->amplitude), MAX_Y_COORD - 1);
+	}
+}
+
+/**
+ * @brief Fill a chunk of a chunk column with terrain
+ * @param terrain The terrain generator
+ * @param blocks The blocks of the terrain
+ * @param heights The heights of the ground of the chunk column
+ * @param cy The y coordinate of the chunk, in chunks
+ * @param chunk The chunk to fill, holding only air
+ * @note The blocks are written straight into the chunk, its masks are not updated
+*/
+void TerrainGenerator_fill(const TerrainGenerator* terrain, const TerrainBlocks& blocks, const TerrainHeights& heights, int cy, Chunk* chunk) {
+	int y0 = cy * Y_CHUNK_SIZE;
+	for(int z = 0; z < Z_CHUNK_SIZE; z++) {
+		for(int x = 0; x < X_CHUNK_SIZE; x++) {
+			int height = heights[x + z * X_CHUNK_SIZE];
+			Block surface = height <= terrain->sea_level ? blocks.sand : blocks.grass;
+			int top = std::min(std::max(height, terrain->sea_level) - y0, Y_CHUNK_SIZE - 1);
+			for(int y = 0; y <= top; y++) {
+				int depth = height - (y0 + y);
+				chunk->blocks[z][y][x] = depth < 0 ? blocks.water : (depth == 0 ? surface : (depth <= terrain->dirt_depth ? blocks.dirt : blocks.stone));
+			}
+		}
+	}
+}
+
+/**
+ * @brief Get the chunk generator of a terrain, for a chunk streamer
+ * @param terrain The terrain generator
+ * @param palette The palette of the world, the colors of the terrain being added to it now
+ * @return The chunk generator, which only reads the palette so it can run on any thread
+ * @note The blocks whose color does not fit in the palette are generated as air
+ * @note The heights of a chunk column are computed once for all its chunks
+*/
+ChunkGenerator TerrainGenerator_chunk_generator(TerrainGenerator terrain, Palette* palette) {
+	TerrainBlocks blocks;
+	TerrainGenerator_blocks(&terrain, palette, &blocks);
+	auto cache = std::make_shared<TerrainHeightsCache>();
+	return [terrain, blocks, cache](coords3 pos, Chunk* chunk, Palette*) {
+		coords3 column = {pos.x, 0, pos.z};
+		TerrainHeights heights;
+		bool cached;
+		{
+			std::lock_guard<std::mutex> guard(cache->lock);
+			auto found = cache->heights.find(column);
+			cached = found != cache->heights.end();
+			if(cached) {
+				heights = found->second;
+			}
+		}
+		if(!cached) {
+			// Computed unlocked, two workers may both compute the heights of a chunk column
+			TerrainGenerator_heights(&terrain, pos.x, pos.z, &heights);
+			std::lock_guard<std::mutex> guard(cache->lock);
+			if(cache->heights.size() >= TERRAIN_HEIGHTS_CACHE) {
+				cache->heights.clear();
+			}
+			cache->heights[column] = heights;
+		}
+		TerrainGenerator_fill(&terrain, blocks, heights, pos.y, chunk);
+	};
+}
+
+/**
+ * @brief Generate the terrain of the chunk columns of a range, in parallel
+ * @param terrain The terrain generator
+ * @param palette The palette, the colors of the terrain being added to it first
+ * @param jobs The job system the chunk columns are generated on
+ * @param origin The position of the first chunk column of the range in the unbounded world, in chunks (y is ignored)
+ * @param size The number of chunk columns along x and z of the range (y is ignored)
+ * @param get The function giving the chunk of a position of the range, holding only air (called from the workers)
+ * @return Whether every color of the terrain is in the palette, the blocks of the missing ones being generated as air
+ * @note The masks of the chunks are updated
+*/
+template<typename ChunkGetter>
+bool TerrainGenerator_generate(const TerrainGenerator* terrain, Palette* palette, JobSystem* jobs, coords3 origin, coords3 size, ChunkGetter get) {
+	TerrainBlocks blocks;
+	bool colors = TerrainGenerator_blocks(terrain, palette, &blocks);
+	JobSystem_parallel_for(jobs, size.x * size.z, [&](int column) {
+		int cx = origin.x + column % size.x;
+		int cz = origin.z + column / size.x;
+		TerrainHeights heights;
+		TerrainGenerator_heights(terrain, cx, cz, &heights);
+		int top = (std::max(*std::max_element(heights.begin(), heights.end()), terrain->sea_level)) / Y_CHUNK_SIZE;
+		for(int cy = 0; cy <= top; cy++) {
+			Chunk* chunk = get(coords3{cx, cy, cz});
+			TerrainGenerator_fill(terrain, blocks, heights, cy, chunk);
+			Chunk_update_masks(chunk, palette);
+		}
+	});
+	return colors;
+}
+
+/**
+ * @brief Replace the chunks of a world with terrain, generated in parallel
+ * @param world The world, holding only air
+ * @param terrain The terrain generator
+ * @param jobs The job system the chunk columns are generated on
+ * @return Whether every color of the terrain is in the palette of the world, the blocks of the missing ones being generated as air
+ * @note The world window is generated where it is, every chunk being marked dirty
+*/
+bool World_generate(World* world, const TerrainGenerator* terrain, JobSystem* jobs) {
+	bool colors = TerrainGenerator_generate(terrain, &world->palette, jobs, world->origin, {X_CHUNK_COUNT, Y_CHUNK_COUNT, Z_CHUNK_COUNT}, [world](coords3 pos) {
+		return World_get_chunk(world, pos.x - world->origin.x, pos.y, pos.z - world->origin.z);
+	});
+	for(int cz = 0; cz < Z_CHUNK_COUNT; cz++) {
+		for(int cy = 0; cy < Y_CHUNK_COUNT; cy++) {
+			for(int cx = 0; cx < X_CHUNK_COUNT; cx++) {
+				World_get_chunk(world, cx, cy, cz)->version++;
+				World_mark_dirty(world, cx, cy, cz);
+			}
+		}
+	}
+	return colors;
+}
+
+#endif
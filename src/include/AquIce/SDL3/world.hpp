@@ -1,8 +1,12 @@
 #ifndef __AQUICE_SDL3_WORLD_HPP__
-#define __AQUICE_SDL3_WORLD_HPP__ 
+#define __AQUICE_SDL3_WORLD_HPP__
 
 #include <array>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
 
+#include "SDL.hpp"
 #include "../utils/ColorCodes.h"
 
 #define MAX_X_COORD 128
@@ -13,28 +17,775 @@
 #define Y_CHUNK_SIZE 8
 #define Z_CHUNK_SIZE 8
 
+#define X_CHUNK_COUNT (MAX_X_COORD / X_CHUNK_SIZE)
+#define Y_CHUNK_COUNT (MAX_Y_COORD / Y_CHUNK_SIZE)
+#define Z_CHUNK_COUNT (MAX_Z_COORD / Z_CHUNK_SIZE)
+
+/**
+ * @brief The number of chunks in the world
+*/
+#define WORLD_CHUNK_COUNT (X_CHUNK_COUNT * Y_CHUNK_COUNT * Z_CHUNK_COUNT)
+
+/**
+ * @brief The bits of a chunk mask word where x is the lowest / highest coordinate of the chunk
+*/
+#define CHUNK_MASK_X_LOW 0x0101010101010101ULL
+#define CHUNK_MASK_X_HIGH 0x8080808080808080ULL
+/**
+ * @brief The bits of a chunk mask word where y is the lowest / highest coordinate of the chunk
+*/
+#define CHUNK_MASK_Y_LOW 0x00000000000000FFULL
+#define CHUNK_MASK_Y_HIGH 0xFF00000000000000ULL
+
+/**
+ * @brief The number of colors of a palette
+*/
+#define PALETTE_SIZE 256
+
+/**
+ * @brief The light level of the blocks open to the sky, the highest one
+*/
+#define LIGHT_MAX 15
+
+static_assert(X_CHUNK_SIZE == 8 && Y_CHUNK_SIZE == 8, "A chunk mask word must hold exactly one z layer of a chunk");
+
 typedef struct Block {
-	RGBA color;
+	/**
+	 * @brief The index of the color of the block in the palette of its world (0 for air)
+	*/
+	uint8_t id;
 } Block;
 
-typedef std::array<Block, MAX_X_COORD> ChunkBarBlocks;
+/**
+ * @brief The colors the blocks of a world refer to
+*/
+typedef struct Palette {
+	/**
+	 * @brief The colors, the first one being air
+	*/
+	std::array<RGBA, PALETTE_SIZE> colors;
+	/**
+	 * @brief The number of colors used
+	*/
+	int count;
+	/**
+	 * @brief Incremented whenever the colors change, to tell when a copy of the palette is out of date
+	*/
+	uint32_t version;
+} Palette;
+
+typedef std::array<Block, X_CHUNK_SIZE> ChunkBarBlocks;
 
-typedef std::array<ChunkBarBlocks, MAX_Y_COORD> ChunkLayerBlocks;
+typedef std::array<ChunkBarBlocks, Y_CHUNK_SIZE> ChunkLayerBlocks;
 
-typedef std::array<ChunkLayerBlocks, MAX_Z_COORD> ChunkBlocks;
+typedef std::array<ChunkLayerBlocks, Z_CHUNK_SIZE> ChunkBlocks;
+
+/**
+ * @brief The light levels of the blocks of a chunk (0 to LIGHT_MAX), indexed like its blocks
+*/
+typedef std::array<std::array<std::array<uint8_t, X_CHUNK_SIZE>, Y_CHUNK_SIZE>, Z_CHUNK_SIZE> ChunkLight;
+
+/**
+ * @brief A bitset holding one bit per block of a chunk
+ * @note There is one word per z layer, the bit of a block in its word being x + y * X_CHUNK_SIZE
+*/
+typedef std::array<uint64_t, Z_CHUNK_SIZE> ChunkMask;
+
+/**
+ * @brief The faces of a block
+*/
+typedef enum Face {
+	FACE_NEG_X,
+	FACE_POS_X,
+	FACE_NEG_Y,
+	FACE_POS_Y,
+	FACE_NEG_Z,
+	FACE_POS_Z,
+	FACE_COUNT
+} Face;
+
+/**
+ * @brief Get the normal of a face
+ * @param face The face
+ * @return The normal of the face
+*/
+coords3 Face_normal(Face face) {
+	int sign = face % 2 == 0 ? -1 : 1;
+	return {
+		face / 2 == 0 ? sign : 0,
+		face / 2 == 1 ? sign : 0,
+		face / 2 == 2 ? sign : 0
+	};
+}
+
+/**
+ * @brief The exposed face masks of a chunk, one mask per face direction
+*/
+typedef std::array<ChunkMask, FACE_COUNT> ChunkFaceMasks;
 
 typedef struct Chunk {
 	ChunkBlocks blocks;
+	/**
+	 * @brief The blocks of the chunk which are not air
+	*/
+	ChunkMask occupancy;
+	/**
+	 * @brief The blocks of the chunk which hide their neighbors
+	*/
+	ChunkMask opacity;
+	/**
+	 * @brief The version of the chunk, incremented on every block write
+	*/
+	uint32_t version;
 } Chunk;
 
-typedef std::array<Chunk, MAX_X_COORD / X_CHUNK_SIZE> WorldChunkBar;
+/**
+ * @brief The shading of a chunk, derived from its blocks and the ones around it
+ * @note Kept out of the chunk, so lighting a chunk mapped from a snapshot never writes to its pages
+*/
+typedef struct ChunkState {
+	/**
+	 * @brief The light levels of the blocks of the chunk, kept up to date by a world lighting
+	*/
+	ChunkLight light;
+	/**
+	 * @brief The blocks of the chunk the sun does not reach, kept up to date by sun shadows
+	*/
+	ChunkMask shadow;
+	/**
+	 * @brief The version of the light and the shadows of the chunk, incremented whenever they change
+	*/
+	uint32_t light_version;
+} ChunkState;
+
+typedef std::array<Chunk*, X_CHUNK_COUNT> WorldChunkBar;
 
-typedef std::array<WorldChunkBar, MAX_Y_COORD / Y_CHUNK_SIZE> WorldChunkLayer;
+typedef std::array<WorldChunkBar, Y_CHUNK_COUNT> WorldChunkLayer;
 
-typedef std::array<WorldChunkLayer, MAX_Z_COORD / Z_CHUNK_SIZE> WorldChunks;
+typedef std::array<WorldChunkLayer, Z_CHUNK_COUNT> WorldChunks;
+
+struct EditJournal;
 
 typedef struct World {
+	/**
+	 * @brief The chunks of the world, owned by the world itself or by a chunk streamer
+	*/
 	WorldChunks chunks;
+	/**
+	 * @brief The chunks owned by the world (unused when they are streamed)
+	*/
+	std::vector<Chunk> storage;
+	/**
+	 * @brief The shading of the chunks of the world, indexed by World_chunk_index, owned along with the chunks
+	*/
+	std::array<ChunkState*, WORLD_CHUNK_COUNT> states;
+	/**
+	 * @brief The shading of the chunks owned by the world, indexed by World_chunk_index (unused when they are streamed)
+	*/
+	std::vector<ChunkState> state_storage;
+	/**
+	 * @brief The position of the first chunk of the world in an unbounded world, in chunks
+	 * @note The world is a window on the unbounded world, which a chunk streamer moves around
+	*/
+	coords3 origin;
+	/**
+	 * @brief The colors of the blocks
+	*/
+	Palette palette;
+	/**
+	 * @brief The indices of the chunks modified since their last meshing
+	*/
+	std::vector<int> dirty;
+	/**
+	 * @brief Whether each chunk is in the dirty list, indexed by World_chunk_index
+	 * @note Kept out of the chunks, so marking a chunk mapped from a snapshot never writes to its pages
+	*/
+	std::array<bool, WORLD_CHUNK_COUNT> marked;
+	/**
+	 * @brief The journal the bulk edits of the world are recorded in (nullptr to not record them)
+	*/
+	struct EditJournal* journal;
 } World;
 
-#endif
\ No newline at end of file
+/**
+ * @brief Check whether a block is not air
+ * @param block The block
+ * @return Whether the block is not air
+*/
+bool Block_is_solid(Block block) {
+	return block.id != 0;
+}
+
+/**
+ * @brief Check whether a block hides the blocks behind it
+ * @param palette The palette of the block
+ * @param block The block
+ * @return Whether the block is opaque
+*/
+bool Block_is_opaque(const Palette* palette, Block block) {
+	return block.id != 0 && palette->colors[block.id].a == 255;
+}
+
+/**
+ * @brief Get the block of a color
+ * @param palette The palette
+ * @param rgba The RGBA color (fully transparent colors are air)
+ * @param block The block to fill, air when the color cannot be added
+ * @return Whether the color is in the palette, it being added if needed
+ * @note Fails once the palette is full and does not hold the exact color
+*/
+bool Palette_block(Palette* palette, RGBA rgba, Block* block) {
+	*block = Block{0};
+	if(rgba.a == 0) {
+		return true;
+	}
+	for(int id = 1; id < palette->count; id++) {
+		RGBA color = palette->colors[id];
+		if(color.r == rgba.r && color.g == rgba.g && color.b == rgba.b && color.a == rgba.a) {
+			*block = Block{(uint8_t)id};
+			return true;
+		}
+	}
+	if(palette->count == PALETTE_SIZE) {
+		return false;
+	}
+	palette->colors[palette->count] = rgba;
+	*block = Block{(uint8_t)palette->count++};
+	palette->version++;
+	return true;
+}
+
+/**
+ * @brief Get the bit of a block in its chunk mask word
+ * @param x The x coordinate of the block in the chunk
+ * @param y The y coordinate of the block in the chunk
+ * @return The bit of the block
+*/
+uint64_t ChunkMask_bit(int x, int y) {
+	return 1ULL << (x + y * X_CHUNK_SIZE);
+}
+
+/**
+ * @brief Set a block of a chunk
+ * @param chunk The chunk
+ * @param x The x coordinate of the block in the chunk
+ * @param y The y coordinate of the block in the chunk
+ * @param z The z coordinate of the block in the chunk
+ * @param block The block
+ * @param palette The palette of the block
+ * @note The occupancy and opacity masks of the chunk are updated accordingly
+*/
+void Chunk_set_block(Chunk* chunk, int x, int y, int z, Block block, const Palette* palette) {
+	uint64_t bit = ChunkMask_bit(x, y);
+	chunk->blocks[z][y][x] = block;
+	chunk->occupancy[z] = Block_is_solid(block) ? chunk->occupancy[z] | bit : chunk->occupancy[z] & ~bit;
+	chunk->opacity[z] = Block_is_opaque(palette, block) ? chunk->opacity[z] | bit : chunk->opacity[z] & ~bit;
+	chunk->version++;
+}
+
+/**
+ * @brief Recompute the occupancy and opacity masks of a chunk from its blocks
+ * @param chunk The chunk
+ * @param palette The palette of the blocks
+ * @note For writes made straight into the blocks of the chunk
+*/
+void Chunk_update_masks(Chunk* chunk, const Palette* palette) {
+	for(int z = 0; z < Z_CHUNK_SIZE; z++) {
+		uint64_t occupancy = 0;
+		uint64_t opacity = 0;
+		for(int y = 0; y < Y_CHUNK_SIZE; y++) {
+			for(int x = 0; x < X_CHUNK_SIZE; x++) {
+				Block block = chunk->blocks[z][y][x];
+				occupancy |= (uint64_t)Block_is_solid(block) << (x + y * X_CHUNK_SIZE);
+				opacity |= (uint64_t)Block_is_opaque(palette, block) << (x + y * X_CHUNK_SIZE);
+			}
+		}
+		chunk->occupancy[z] = occupancy;
+		chunk->opacity[z] = opacity;
+	}
+}
+
+/**
+ * @brief Check whether a chunk only contains air
+ * @param chunk The chunk
+ * @return Whether the chunk is empty
+*/
+bool Chunk_is_empty(const Chunk* chunk) {
+	uint64_t occupied = 0;
+	for(uint64_t word : chunk->occupancy) {
+		occupied |= word;
+	}
+	return occupied == 0;
+}
+
+/**
+ * @brief Get the opacity masks of the neighbors of a chunk
+ * @param neighbors The neighboring chunks, indexed by the face they touch (nullptr for air)
+ * @return The opacity masks of the neighbors, indexed by the face they touch
+*/
+std::array<ChunkMask, FACE_COUNT> Chunk_neighbors_opacity(const std::array<const Chunk*, FACE_COUNT>& neighbors) {
+	std::array<ChunkMask, FACE_COUNT> nopacity = {};
+	for(int face = 0; face < FACE_COUNT; face++) {
+		if(neighbors[face]) {
+			nopacity[face] = neighbors[face]->opacity;
+		}
+	}
+	return nopacity;
+}
+
+/**
+ * @brief Compute the exposed faces of a chunk
+ * @param chunk The chunk
+ * @param nopacity The opacity masks of the neighboring chunks, indexed by the face they touch
+ * @param faces The exposed face masks to fill
+ * @note A face is exposed when its block is not air and the block in front of it is not opaque
+*/
+void Chunk_exposed_faces(const Chunk* chunk, const std::array<ChunkMask, FACE_COUNT>& nopacity, ChunkFaceMasks* faces) {
+	const ChunkMask& occupancy = chunk->occupancy;
+	const ChunkMask& opacity = chunk->opacity;
+
+	for(int z = 0; z < Z_CHUNK_SIZE; z++) {
+		uint64_t opq = opacity[z];
+		uint64_t neg_x = (opq << 1 & ~CHUNK_MASK_X_LOW) | (nopacity[FACE_NEG_X][z] & CHUNK_MASK_X_HIGH) >> (X_CHUNK_SIZE - 1);
+		uint64_t pos_x = (opq >> 1 & ~CHUNK_MASK_X_HIGH) | (nopacity[FACE_POS_X][z] & CHUNK_MASK_X_LOW) << (X_CHUNK_SIZE - 1);
+		uint64_t neg_y = opq << X_CHUNK_SIZE | (nopacity[FACE_NEG_Y][z] & CHUNK_MASK_Y_HIGH) >> (64 - X_CHUNK_SIZE);
+		uint64_t pos_y = opq >> X_CHUNK_SIZE | (nopacity[FACE_POS_Y][z] & CHUNK_MASK_Y_LOW) << (64 - X_CHUNK_SIZE);
+		uint64_t neg_z = z > 0 ? opacity[z - 1] : nopacity[FACE_NEG_Z][Z_CHUNK_SIZE - 1];
+		uint64_t pos_z = z < Z_CHUNK_SIZE - 1 ? opacity[z + 1] : nopacity[FACE_POS_Z][0];
+
+		(*faces)[FACE_NEG_X][z] = occupancy[z] & ~neg_x;
+		(*faces)[FACE_POS_X][z] = occupancy[z] & ~pos_x;
+		(*faces)[FACE_NEG_Y][z] = occupancy[z] & ~neg_y;
+		(*faces)[FACE_POS_Y][z] = occupancy[z] & ~pos_y;
+		(*faces)[FACE_NEG_Z][z] = occupancy[z] & ~neg_z;
+		(*faces)[FACE_POS_Z][z] = occupancy[z] & ~pos_z;
+	}
+}
+
+/**
+ * @brief Get the index of a chunk in the world
+ * @param cx The x coordinate of the chunk
+ * @param cy The y coordinate of the chunk
+ * @param cz The z coordinate of the chunk
+ * @return The index of the chunk
+*/
+int World_chunk_index(int cx, int cy, int cz) {
+	return cx + X_CHUNK_COUNT * (cy + Y_CHUNK_COUNT * cz);
+}
+
+/**
+ * @brief Create a new world filled with air
+ * @return The world pointer
+ * @note The world is too big for the stack, it must be freed with World_free
+*/
+World* World_new() {
+	World* world = new World();
+	world->palette.count = 1;
+	world->palette.version = 0;
+	world->origin = {0, 0, 0};
+	world->journal = nullptr;
+	world->marked.fill(false);
+	world->storage.resize(WORLD_CHUNK_COUNT);
+	world->state_storage.resize(WORLD_CHUNK_COUNT);
+	for(int cz = 0; cz < Z_CHUNK_COUNT; cz++) {
+		for(int cy = 0; cy < Y_CHUNK_COUNT; cy++) {
+			for(int cx = 0; cx < X_CHUNK_COUNT; cx++) {
+				world->chunks[cz][cy][cx] = &world->storage[World_chunk_index(cx, cy, cz)];
+				world->states[World_chunk_index(cx, cy, cz)] = &world->state_storage[World_chunk_index(cx, cy, cz)];
+			}
+		}
+	}
+	return world;
+}
+
+/**
+ * @brief Free a world
+ * @param world The world pointer
+*/
+void World_free(World* world) {
+	delete world;
+}
+
+/**
+ * @brief Get a chunk of the world
+ * @param world The world
+ * @param cx The x coordinate of the chunk
+ * @param cy The y coordinate of the chunk
+ * @param cz The z coordinate of the chunk
+ * @return The chunk, or nullptr if it is outside the world
+*/
+Chunk* World_get_chunk(World* world, int cx, int cy, int cz) {
+	if(cx < 0 || cy < 0 || cz < 0 || cx >= X_CHUNK_COUNT || cy >= Y_CHUNK_COUNT || cz >= Z_CHUNK_COUNT) {
+		return nullptr;
+	}
+	return world->chunks[cz][cy][cx];
+}
+
+/**
+ * @brief Get the shading of a chunk of the world
+ * @param world The world
+ * @param cx The x coordinate of the chunk
+ * @param cy The y coordinate of the chunk
+ * @param cz The z coordinate of the chunk
+ * @return The shading of the chunk, or nullptr if it is outside the world
+*/
+ChunkState* World_get_state(World* world, int cx, int cy, int cz) {
+	if(cx < 0 || cy < 0 || cz < 0 || cx >= X_CHUNK_COUNT || cy >= Y_CHUNK_COUNT || cz >= Z_CHUNK_COUNT) {
+		return nullptr;
+	}
+	return world->states[World_chunk_index(cx, cy, cz)];
+}
+
+/**
+ * @brief Mark a chunk of the world as needing a new mesh
+ * @param world The world
+ * @param cx The x coordinate of the chunk
+ * @param cy The y coordinate of the chunk
+ * @param cz The z coordinate of the chunk
+*/
+void World_mark_dirty(World* world, int cx, int cy, int cz) {
+	if(World_get_chunk(world, cx, cy, cz) && !world->marked[World_chunk_index(cx, cy, cz)]) {
+		world->marked[World_chunk_index(cx, cy, cz)] = true;
+		world->dirty.push_back(World_chunk_index(cx, cy, cz));
+	}
+}
+
+/**
+ * @brief Mark the neighbors of a chunk of the world whose border changed as needing a new mesh
+ * @param world The world
+ * @param cx The x coordinate of the chunk
+ * @param cy The y coordinate of the chunk
+ * @param cz The z coordinate of the chunk
+ * @param changed The blocks of the chunk that changed
+ * @param diagonals Whether the neighbors across an edge or a corner read the border too, as the occlusion of their corners does
+ * @note The chunk itself is not marked
+*/
+void World_mark_dirty_around(World* world, int cx, int cy, int cz, const ChunkMask& changed, bool diagonals) {
+	// The blocks of the border of the chunk on each side of an axis, and the whole chunk along it
+	const uint64_t x_borders[3] = {CHUNK_MASK_X_LOW, ~(uint64_t)0, CHUNK_MASK_X_HIGH};
+	const uint64_t y_borders[3] = {CHUNK_MASK_Y_LOW, ~(uint64_t)0, CHUNK_MASK_Y_HIGH};
+	for(int dz = -1; dz <= 1; dz++) {
+		uint64_t layers = 0;
+		for(int z = 0; z < Z_CHUNK_SIZE; z++) {
+			if(dz == 0 || z == (dz < 0 ? 0 : Z_CHUNK_SIZE - 1)) {
+				layers |= changed[z];
+			}
+		}
+		for(int dy = -1; dy <= 1; dy++) {
+			for(int dx = -1; dx <= 1; dx++) {
+				int axes = (dx != 0) + (dy != 0) + (dz != 0);
+				if(axes > 0 && (diagonals || axes == 1) && (layers & x_borders[dx + 1] & y_borders[dy + 1])) {
+					World_mark_dirty(world, cx + dx, cy + dy, cz + dz);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief Finish writing straight into the blocks of a chunk of the world
+ * @param world The world
+ * @param cx The x coordinate of the chunk
+ * @param cy The y coordinate of the chunk
+ * @param cz The z coordinate of the chunk
+ * @note The chunk gets its masks recomputed and a new version, and it is marked dirty
+ * @note along with the neighbors (diagonal ones included) whose border the opacity changed on
+*/
+void World_chunk_changed(World* world, int cx, int cy, int cz) {
+	Chunk* chunk = World_get_chunk(world, cx, cy, cz);
+	ChunkMask before = chunk->opacity;
+	Chunk_update_masks(chunk, &world->palette);
+	chunk->version++;
+	World_mark_dirty(world, cx, cy, cz);
+
+	ChunkMask changed;
+	for(int z = 0; z < Z_CHUNK_SIZE; z++) {
+		changed[z] = before[z] ^ chunk->opacity[z];
+	}
+	World_mark_dirty_around(world, cx, cy, cz, changed, true);
+}
+
+/**
+ * @brief The chunks of a world the shading derived from their opacity was last brought up to date with
+ * @note Shared by the world lighting and the sun shadows, to find the chunks that changed or moved since their last update
+*/
+typedef struct ChunkTracker {
+	/**
+	 * @brief The chunks of the world at the last update, indexed by World_chunk_index
+	*/
+	std::array<const Chunk*, WORLD_CHUNK_COUNT> sources;
+	/**
+	 * @brief The versions of the chunks of the world at the last update, indexed by World_chunk_index
+	*/
+	std::array<uint32_t, WORLD_CHUNK_COUNT> versions;
+	/**
+	 * @brief The opacity masks of the chunks of the world at the last update, indexed by World_chunk_index
+	*/
+	std::array<ChunkMask, WORLD_CHUNK_COUNT> opacity;
+	/**
+	 * @brief The origin of the world at the last update
+	*/
+	coords3 origin;
+	/**
+	 * @brief Whether there was an update
+	*/
+	bool tracked;
+	/**
+	 * @brief The blocks whose shading changed during the current update, indexed by World_chunk_index
+	*/
+	std::array<ChunkMask, WORLD_CHUNK_COUNT> changed;
+} ChunkTracker;
+
+/**
+ * @brief Create a new chunk tracker
+ * @return The chunk tracker pointer, no chunk being in the window before the first update
+*/
+ChunkTracker* ChunkTracker_new() {
+	ChunkTracker* tracker = new ChunkTracker();
+	tracker->sources.fill(nullptr);
+	tracker->versions.fill(0);
+	tracker->origin = {0, 0, 0};
+	tracker->tracked = false;
+	tracker->changed.fill({});
+	return tracker;
+}
+
+/**
+ * @brief Free a chunk tracker
+ * @param tracker The chunk tracker pointer
+*/
+void ChunkTracker_free(ChunkTracker* tracker) {
+	delete tracker;
+}
+
+/**
+ * @brief Get the index a chunk of a world had at the last update of a chunk tracker
+ * @param tracker The chunk tracker
+ * @param world The world
+ * @param cx The x coordinate of the chunk
+ * @param cy The y coordinate of the chunk
+ * @param cz The z coordinate of the chunk
+ * @return The index of the chunk at the last update, or -1 if it was not in the window then (or was replaced since)
+*/
+int ChunkTracker_previous(const ChunkTracker* tracker, World* world, int cx, int cy, int cz) {
+	int px = cx + world->origin.x - tracker->origin.x;
+	int py = cy + world->origin.y - tracker->origin.y;
+	int pz = cz + world->origin.z - tracker->origin.z;
+	if(!tracker->tracked || px < 0 || py < 0 || pz < 0 || px >= X_CHUNK_COUNT || py >= Y_CHUNK_COUNT || pz >= Z_CHUNK_COUNT) {
+		return -1;
+	}
+	int index = World_chunk_index(px, py, pz);
+	return tracker->sources[index] == World_get_chunk(world, cx, cy, cz) ? index : -1;
+}
+
+/**
+ * @brief Check whether the window of a world moved or one of its chunks was replaced since the last update of a chunk tracker
+ * @param tracker The chunk tracker
+ * @param world The world
+ * @return Whether the window moved or a chunk was replaced, always true before the first update
+*/
+bool ChunkTracker_moved(const ChunkTracker* tracker, World* world) {
+	bool moved = !tracker->tracked
+		|| tracker->origin.x != world->origin.x
+		|| tracker->origin.y != world->origin.y
+		|| tracker->origin.z != world->origin.z;
+	for(int index = 0; index < WORLD_CHUNK_COUNT && !moved; index++) {
+		moved = tracker->sources[index] != World_get_chunk(world, index % X_CHUNK_COUNT, index / X_CHUNK_COUNT % Y_CHUNK_COUNT, index / (X_CHUNK_COUNT * Y_CHUNK_COUNT));
+	}
+	return moved;
+}
+
+/**
+ * @brief Get the blocks of a chunk of a world whose opacity changed since the last update of a chunk tracker
+ * @param tracker The chunk tracker
+ * @param world The world
+ * @param cx The x coordinate of the chunk
+ * @param cy The y coordinate of the chunk
+ * @param cz The z coordinate of the chunk
+ * @return The blocks whose opacity changed, none for a chunk that was not in the window at the last update
+*/
+ChunkMask ChunkTracker_flipped(const ChunkTracker* tracker, World* world, int cx, int cy, int cz) {
+	ChunkMask flipped = {};
+	int previous = ChunkTracker_previous(tracker, world, cx, cy, cz);
+	const Chunk* chunk = World_get_chunk(world, cx, cy, cz);
+	if(previous < 0 || chunk->version == tracker->versions[previous]) {
+		return flipped;
+	}
+	for(int z = 0; z < Z_CHUNK_SIZE; z++) {
+		flipped[z] = chunk->opacity[z] ^ tracker->opacity[previous][z];
+	}
+	return flipped;
+}
+
+/**
+ * @brief Flag a block of a world whose shading changed during the current update of a chunk tracker
+ * @param tracker The chunk tracker
+ * @param x The x coordinate of the block
+ * @param y The y coordinate of the block
+ * @param z The z coordinate of the block
+*/
+void ChunkTracker_touch(ChunkTracker* tracker, int x, int y, int z) {
+	tracker->changed[World_chunk_index(x / X_CHUNK_SIZE, y / Y_CHUNK_SIZE, z / Z_CHUNK_SIZE)][z % Z_CHUNK_SIZE] |= ChunkMask_bit(x % X_CHUNK_SIZE, y % Y_CHUNK_SIZE);
+}
+
+/**
+ * @brief End the update of a chunk tracker
+ * @param tracker The chunk tracker
+ * @param world The world
+ * @return The number of chunks whose shading changed
+ * @note The chunks whose shading changed get a new light version and are marked dirty, along with the neighbors whose
+ * @note faces the changed blocks of their border are in front of
+*/
+int ChunkTracker_commit(ChunkTracker* tracker, World* world) {
+	int updated = 0;
+	for(int index = 0; index < WORLD_CHUNK_COUNT; index++) {
+		int cx = index % X_CHUNK_COUNT;
+		int cy = index / X_CHUNK_COUNT % Y_CHUNK_COUNT;
+		int cz = index / (X_CHUNK_COUNT * Y_CHUNK_COUNT);
+		Chunk* chunk = World_get_chunk(world, cx, cy, cz);
+		tracker->sources[index] = chunk;
+		tracker->versions[index] = chunk->version;
+		tracker->opacity[index] = chunk->opacity;
+		ChunkMask& changed = tracker->changed[index];
+		uint64_t any = 0;
+		for(uint64_t bits : changed) {
+			any |= bits;
+		}
+		if(!any) {
+			continue;
+		}
+		updated++;
+		world->states[index]->light_version++;
+		World_mark_dirty(world, cx, cy, cz);
+		World_mark_dirty_around(world, cx, cy, cz, changed, false);
+		changed = {};
+	}
+	tracker->origin = world->origin;
+	tracker->tracked = true;
+	return updated;
+}
+
+/**
+ * @brief Get the neighbors of a chunk of the world
+ * @param world The world
+ * @param cx The x coordinate of the chunk
+ * @param cy The y coordinate of the chunk
+ * @param cz The z coordinate of the chunk
+ * @return The neighboring chunks, indexed by the face they touch
+*/
+std::array<const Chunk*, FACE_COUNT> World_chunk_neighbors(World* world, int cx, int cy, int cz) {
+	return {
+		World_get_chunk(world, cx - 1, cy, cz),
+		World_get_chunk(world, cx + 1, cy, cz),
+		World_get_chunk(world, cx, cy - 1, cz),
+		World_get_chunk(world, cx, cy + 1, cz),
+		World_get_chunk(world, cx, cy, cz - 1),
+		World_get_chunk(world, cx, cy, cz + 1)
+	};
+}
+
+/**
+ * @brief Get the shading of the neighbors of a chunk of the world
+ * @param world The world
+ * @param cx The x coordinate of the chunk
+ * @param cy The y coordinate of the chunk
+ * @param cz The z coordinate of the chunk
+ * @return The shading of the neighboring chunks, indexed by the face they touch
+*/
+std::array<const ChunkState*, FACE_COUNT> World_state_neighbors(World* world, int cx, int cy, int cz) {
+	return {
+		World_get_state(world, cx - 1, cy, cz),
+		World_get_state(world, cx + 1, cy, cz),
+		World_get_state(world, cx, cy - 1, cz),
+		World_get_state(world, cx, cy + 1, cz),
+		World_get_state(world, cx, cy, cz - 1),
+		World_get_state(world, cx, cy, cz + 1)
+	};
+}
+
+/**
+ * @brief Check whether a position is inside the world
+ * @param x The x coordinate
+ * @param y The y coordinate
+ * @param z The z coordinate
+ * @return Whether the position is inside the world
+*/
+bool World_contains(int x, int y, int z) {
+	return x >= 0 && y >= 0 && z >= 0 && x < MAX_X_COORD && y < MAX_Y_COORD && z < MAX_Z_COORD;
+}
+
+/**
+ * @brief Get the position in the unbounded world of a block of the world
+ * @param world The world
+ * @param pos The position of the block in the world
+ * @return The position of the block in the unbounded world
+*/
+coords3 World_unbounded_pos(const World* world, coords3 pos) {
+	return {
+		pos.x + world->origin.x * X_CHUNK_SIZE,
+		pos.y + world->origin.y * Y_CHUNK_SIZE,
+		pos.z + world->origin.z * Z_CHUNK_SIZE
+	};
+}
+
+/**
+ * @brief Get the position in the world of a block of the unbounded world
+ * @param world The world
+ * @param pos The position of the block in the unbounded world
+ * @return The position of the block in the world, outside of it if the block is not in the window
+*/
+coords3 World_window_pos(const World* world, coords3 pos) {
+	return {
+		pos.x - world->origin.x * X_CHUNK_SIZE,
+		pos.y - world->origin.y * Y_CHUNK_SIZE,
+		pos.z - world->origin.z * Z_CHUNK_SIZE
+	};
+}
+
+/**
+ * @brief Get a block of the world
+ * @param world The world
+ * @param x The x coordinate of the block
+ * @param y The y coordinate of the block
+ * @param z The z coordinate of the block
+ * @return The block (air if outside the world)
+*/
+Block World_get_block(World* world, int x, int y, int z) {
+	if(!World_contains(x, y, z)) {
+		return Block{};
+	}
+	return world->chunks[z / Z_CHUNK_SIZE][y / Y_CHUNK_SIZE][x / X_CHUNK_SIZE]->blocks[z % Z_CHUNK_SIZE][y % Y_CHUNK_SIZE][x % X_CHUNK_SIZE];
+}
+
+/**
+ * @brief Compute the exposed faces of a chunk of the world
+ * @param world The world
+ * @param cx The x coordinate of the chunk
+ * @param cy The y coordinate of the chunk
+ * @param cz The z coordinate of the chunk
+ * @param faces The exposed face masks to fill
+*/
+void World_chunk_exposed_faces(World* world, int cx, int cy, int cz, ChunkFaceMasks* faces) {
+	Chunk_exposed_faces(World_get_chunk(world, cx, cy, cz), Chunk_neighbors_opacity(World_chunk_neighbors(world, cx, cy, cz)), faces);
+}
+
+/**
+ * @brief Compute the exposed faces of every chunk of the world
+ * @param world The world
+ * @param faces The exposed face masks to fill, indexed by World_chunk_index (resized to WORLD_CHUNK_COUNT)
+ * @note Empty chunks are skipped and get empty masks
+*/
+void World_exposed_faces(World* world, std::vector<ChunkFaceMasks>* faces) {
+	faces->assign(WORLD_CHUNK_COUNT, ChunkFaceMasks{});
+	for(int cz = 0; cz < Z_CHUNK_COUNT; cz++) {
+		for(int cy = 0; cy < Y_CHUNK_COUNT; cy++) {
+			for(int cx = 0; cx < X_CHUNK_COUNT; cx++) {
+				if(!Chunk_is_empty(World_get_chunk(world, cx, cy, cz))) {
+					World_chunk_exposed_faces(world, cx, cy, cz, &(*faces)[World_chunk_index(cx, cy, cz)]);
+				}
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,495 @@
+#ifndef __AQUICE_UTILS_JOBS_HPP__
+#define __AQUICE_UTILS_JOBS_HPP__
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+
+/**
+ * @brief A job of a job system
+*/
+typedef struct Job {
+	/**
+	 * @brief The task of the job
+	*/
+	std::function<void()> task;
+	/**
+	 * @brief The number of dependencies not finished yet, plus one while the job is being submitted
+	*/
+	std::atomic<int> blockers;
+	/**
+	 * @brief The mutex guarding the continuations and the finished flag
+	*/
+	std::mutex mutex;
+	/**
+	 * @brief The condition the threads waiting for the job wait on
+	*/
+	std::condition_variable condition;
+	/**
+	 * @brief The jobs depending on this one
+	*/
+	std::vector<std::shared_ptr<Job>> continuations;
+	/**
+	 * @brief Whether the job has run
+	*/
+	bool finished;
+} Job;
+
+/**
+ * @brief A handle on a job, kept alive as long as it is referenced
+*/
+typedef std::shared_ptr<Job> JobHandle;
+
+/**
+ * @brief The profiling counters of a job system, summed over its threads
+*/
+typedef struct JobCounters {
+	/**
+	 * @brief The number of jobs submitted
+	*/
+	uint64_t submitted;
+	/**
+	 * @brief The number of jobs run
+	*/
+	uint64_t executed;
+	/**
+	 * @brief The number of jobs a worker took from the deque of another one
+	*/
+	uint64_t stolen;
+	/**
+	 * @brief The number of times a worker went to sleep for lack of jobs
+	*/
+	uint64_t sleeps;
+	/**
+	 * @brief The time spent running jobs, in nanoseconds
+	*/
+	uint64_t busy_ns;
+} JobCounters;
+
+/**
+ * @brief A worker of a job system, with its own deque of jobs
+ * @note The worker takes its newest jobs from the back, the others steal its oldest ones from the front
+*/
+typedef struct alignas(64) JobWorker {
+	/**
+	 * @brief The jobs of the worker
+	*/
+	std::deque<JobHandle> jobs;
+	/**
+	 * @brief The mutex guarding the jobs
+	*/
+	std::mutex mutex;
+	/**
+	 * @brief The profiling counters of the worker
+	*/
+	std::atomic<uint64_t> submitted, executed, stolen, sleeps, busy_ns;
+} JobWorker;
+
+/**
+ * @brief A work-stealing job system, shared by every parallel stage of the engine
+*/
+typedef struct JobSystem {
+	/**
+	 * @brief The worker threads
+	*/
+	std::vector<std::thread> threads;
+	/**
+	 * @brief The workers, the last one holding the counters of the threads which are not workers
+	*/
+	std::vector<std::unique_ptr<JobWorker>> workers;
+	/**
+	 * @brief The number of jobs waiting in the deques
+	*/
+	std::atomic<int> pending;
+	/**
+	 * @brief The number of workers sleeping
+	*/
+	std::atomic<int> sleeping;
+	/**
+	 * @brief The worker the next job submitted from outside the workers goes to
+	*/
+	std::atomic<unsigned> next;
+	/**
+	 * @brief The mutex the sleeping workers wait on
+	*/
+	std::mutex mutex;
+	/**
+	 * @brief The condition the sleeping workers wait on
+	*/
+	std::condition_variable condition;
+	/**
+	 * @brief Whether the workers are running
+	*/
+	std::atomic<bool> running;
+} JobSystem;
+
+/**
+ * @brief The job system of the current thread, when it is one of its workers
+*/
+thread_local JobSystem* JobSystem_current = nullptr;
+/**
+ * @brief The index of the current thread in the workers of JobSystem_current
+*/
+thread_local int JobSystem_current_worker = -1;
+
+/**
+ * @brief Get the index of the current thread in the workers of a job system
+ * @param jobs The job system
+ * @return The index of the worker, or -1 if the thread is not one of its workers
+*/
+int JobSystem_worker(JobSystem* jobs) {
+	return JobSystem_current == jobs ? JobSystem_current_worker : -1;
+}
+
+/**
+ * @brief Get the number of worker threads of a job system
+ * @param jobs The job system
+ * @return The number of worker threads
+*/
+int JobSystem_thread_count(JobSystem* jobs) {
+	return jobs->workers.size() - 1;
+}
+
+/**
+ * @brief Queue a job whose dependencies are all finished
+ * @param jobs The job system
+ * @param job The job
+ * @note A worker queues on its own deque, the other threads spread their jobs over the workers
+*/
+void JobSystem_schedule(JobSystem* jobs, JobHandle job) {
+	int self = JobSystem_worker(jobs);
+	int count = JobSystem_thread_count(jobs);
+	JobWorker* worker = jobs->workers[self >= 0 ? self : jobs->next.fetch_add(1, std::memory_order_relaxed) % count].get();
+	{
+		std::lock_guard<std::mutex> lock(worker->mutex);
+		worker->jobs.push_back(std::move(job));
+	}
+	jobs->pending.fetch_add(1);
+	if(jobs->sleeping.load() > 0) {
+		std::lock_guard<std::mutex> lock(jobs->mutex);
+		jobs->condition.notify_one();
+	}
+}
+
+/**
+ * @brief Submit a job to a job system
+ * @param jobs The job system
+ * @param task The task of the job
+ * @param dependencies The jobs to finish before this one runs (null handles are ignored)
+ * @return The handle of the job
+*/
+JobHandle JobSystem_submit(JobSystem* jobs, std::function<void()> task, const std::vector<JobHandle>& dependencies = {}) {
+	JobHandle job = std::make_shared<Job>();
+	job->task = std::move(task);
+	job->blockers.store(1 + dependencies.size());
+	job->finished = false;
+	int self = JobSystem_worker(jobs);
+	jobs->workers[self >= 0 ? self : JobSystem_thread_count(jobs)]->submitted.fetch_add(1, std::memory_order_relaxed);
+
+	for(const JobHandle& dependency : dependencies) {
+		bool finished = true;
+		if(dependency) {
+			std::lock_guard<std::mutex> lock(dependency->mutex);
+			finished = dependency->finished;
+			if(!finished) {
+				dependency->continuations.push_back(job);
+			}
+		}
+		if(finished) {
+			job->blockers.fetch_sub(1);
+		}
+	}
+	if(job->blockers.fetch_sub(1) == 1) {
+		JobSystem_schedule(jobs, job);
+	}
+	return job;
+}
+
+/**
+ * @brief Submit a continuation of a job
+ * @param jobs The job system
+ * @param job The job to continue (a null handle to start right away)
+ * @param task The task to run once the job is finished
+ * @return The handle of the continuation
+*/
+JobHandle JobSystem_then(JobSystem* jobs, const JobHandle& job, std::function<void()> task) {
+	return JobSystem_submit(jobs, std::move(task), {job});
+}
+
+/**
+ * @brief Run a job and queue the continuations it unblocks
+ * @param jobs The job system
+ * @param job The job
+ * @param counters The worker to count the job on
+*/
+void JobSystem_run_job(JobSystem* jobs, const JobHandle& job, JobWorker* counters) {
+	auto start = std::chrono::steady_clock::now();
+	job->task();
+	job->task = nullptr;
+	counters->busy_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+	counters->executed.fetch_add(1, std::memory_order_relaxed);
+
+	std::vector<JobHandle> continuations;
+	{
+		std::lock_guard<std::mutex> lock(job->mutex);
+		job->finished = true;
+		continuations.swap(job->continuations);
+	}
+	job->condition.notify_all();
+	for(JobHandle& continuation : continuations) {
+		if(continuation->blockers.fetch_sub(1) == 1) {
+			JobSystem_schedule(jobs, std::move(continuation));
+		}
+	}
+}
+
+/**
+ * @brief Run one queued job on the current thread, if there is any
+ * @param jobs The job system
+ * @return Whether a job was run
+ * @note A worker runs its newest job first, then steals the oldest job of the next workers
+ * @note Only the workers run queued jobs, the other threads only run the indices of their own parallel fors
+*/
+bool JobSystem_try_run(JobSystem* jobs) {
+	int self = JobSystem_worker(jobs);
+	int count = JobSystem_thread_count(jobs);
+	JobHandle job;
+	if(self >= 0) {
+		JobWorker* worker = jobs->workers[self].get();
+		std::lock_guard<std::mutex> lock(worker->mutex);
+		if(!worker->jobs.empty()) {
+			job = std::move(worker->jobs.back());
+			worker->jobs.pop_back();
+		}
+	}
+	for(int i = 1; !job && i <= count; i++) {
+		JobWorker* victim = jobs->workers[(std::max(self, 0) + i) % count].get();
+		std::lock_guard<std::mutex> lock(victim->mutex);
+		if(!victim->jobs.empty()) {
+			job = std::move(victim->jobs.front());
+			victim->jobs.pop_front();
+			if(self >= 0) {
+				jobs->workers[self]->stolen.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	}
+	if(!job) {
+		return false;
+	}
+	jobs->pending.fetch_sub(1);
+	JobSystem_run_job(jobs, job, jobs->workers[self >= 0 ? self : count].get());
+	return true;
+}
+
+/**
+ * @brief The loop run by each worker thread
+ * @param jobs The job system
+ * @param index The index of the worker
+*/
+void JobSystem_run(JobSystem* jobs, int index) {
+	JobSystem_current = jobs;
+	JobSystem_current_worker = index;
+	while(true) {
+		if(JobSystem_try_run(jobs)) {
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(jobs->mutex);
+		if(!jobs->running.load() && jobs->pending.load() == 0) {
+			return;
+		}
+		jobs->sleeping.fetch_add(1);
+		jobs->workers[index]->sleeps.fetch_add(1, std::memory_order_relaxed);
+		jobs->condition.wait(lock, [jobs] { return jobs->pending.load() > 0 || !jobs->running.load(); });
+		jobs->sleeping.fetch_sub(1);
+	}
+}
+
+/**
+ * @brief Create a new job system
+ * @param thread_count The number of worker threads (0 for one per hardware thread but the calling one, which runs its own parallel fors)
+ * @return The job system pointer
+*/
+JobSystem* JobSystem_new(int thread_count = 0) {
+	if(thread_count <= 0) {
+		thread_count = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+	}
+	JobSystem* jobs = new JobSystem();
+	jobs->pending.store(0);
+	jobs->sleeping.store(0);
+	jobs->next.store(0);
+	jobs->running.store(true);
+	for(int i = 0; i <= thread_count; i++) {
+		jobs->workers.emplace_back(new JobWorker());
+	}
+	for(auto& worker : jobs->workers) {
+		worker->submitted.store(0);
+		worker->executed.store(0);
+		worker->stolen.store(0);
+		worker->sleeps.store(0);
+		worker->busy_ns.store(0);
+	}
+	for(int i = 0; i < thread_count; i++) {
+		jobs->threads.emplace_back(JobSystem_run, jobs, i);
+	}
+	return jobs;
+}
+
+/**
+ * @brief Wait for a job
+ * @param jobs The job system
+ * @param job The job (a null handle returns right away)
+ * @note A worker runs the queued jobs meanwhile, as the job may be behind them, the other threads sleep until it is done
+*/
+void JobSystem_wait(JobSystem* jobs, const JobHandle& job) {
+	if(!job) {
+		return;
+	}
+	if(JobSystem_worker(jobs) < 0) {
+		std::unique_lock<std::mutex> lock(job->mutex);
+		job->condition.wait(lock, [&job] { return job->finished; });
+		return;
+	}
+	while(true) {
+		{
+			std::lock_guard<std::mutex> lock(job->mutex);
+			if(job->finished) {
+				return;
+			}
+		}
+		if(JobSystem_try_run(jobs)) {
+			continue;
+		}
+		// The job runs elsewhere, check for new jobs now and then while it does
+		std::unique_lock<std::mutex> lock(job->mutex);
+		job->condition.wait_for(lock, std::chrono::milliseconds(1), [&job] { return job->finished; });
+	}
+}
+
+/**
+ * @brief The shared state of a parallel for
+*/
+typedef struct JobParallelFor {
+	/**
+	 * @brief The task to run for each index
+	 * @note Only read while indices are left to take, the caller waiting for them
+	*/
+	const std::function<void(int)>* task;
+	/**
+	 * @brief The number of indices
+	*/
+	int count;
+	/**
+	 * @brief The number of indices taken at once
+	*/
+	int grain;
+	/**
+	 * @brief The first index not taken yet
+	*/
+	std::atomic<int> next;
+	/**
+	 * @brief The number of indices not run yet
+	*/
+	std::atomic<int> remaining;
+	/**
+	 * @brief The mutex the caller waits on
+	*/
+	std::mutex mutex;
+	/**
+	 * @brief The condition the caller waits on until every index is run
+	*/
+	std::condition_variable condition;
+} JobParallelFor;
+
+/**
+ * @brief Take and run the indices of a parallel for, grain by grain, until none is left
+ * @param state The shared state of the parallel for
+*/
+void JobSystem_parallel_run(const std::shared_ptr<JobParallelFor>& state) {
+	while(true) {
+		int begin = state->next.fetch_add(state->grain, std::memory_order_relaxed);
+		if(begin >= state->count) {
+			return;
+		}
+		int end = std::min(begin + state->grain, state->count);
+		for(int i = begin; i < end; i++) {
+			(*state->task)(i);
+		}
+		if(state->remaining.fetch_sub(end - begin, std::memory_order_acq_rel) == end - begin) {
+			std::lock_guard<std::mutex> lock(state->mutex);
+			state->condition.notify_all();
+		}
+	}
+}
+
+/**
+ * @brief Run a task for every index of a range on a job system and wait for all of them
+ * @param jobs The job system
+ * @param count The number of indices
+ * @param task The task to run for each index
+ * @param grain The number of indices taken at once (0 to split the range in about 8 parts per thread)
+ * @note The calling thread and one job per worker take the indices of the range until none is left, the calling thread
+ * @note then sleeps until the last ones run elsewhere are done. It never runs the unrelated jobs of the queues meanwhile.
+*/
+void JobSystem_parallel_for(JobSystem* jobs, int count, std::function<void(int)> task, int grain = 0) {
+	if(count <= 0) {
+		return;
+	}
+	auto state = std::make_shared<JobParallelFor>();
+	state->task = &task;
+	state->count = count;
+	state->grain = grain > 0 ? grain : std::max(1, count / (8 * (JobSystem_thread_count(jobs) + 1)));
+	state->next.store(0);
+	state->remaining.store(count);
+	int helpers = std::min(JobSystem_thread_count(jobs), (count - 1) / state->grain);
+	for(int i = 0; i < helpers; i++) {
+		JobSystem_submit(jobs, [state] { JobSystem_parallel_run(state); });
+	}
+	JobSystem_parallel_run(state);
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->condition.wait(lock, [&state] { return state->remaining.load(std::memory_order_acquire) == 0; });
+}
+
+/**
+ * @brief Read the profiling counters of a job system
+ * @param jobs The job system
+ * @param reset Whether to reset them, to measure the next frame on its own
+ * @return The counters, summed over the threads
+*/
+JobCounters JobSystem_counters(JobSystem* jobs, bool reset = false) {
+	JobCounters counters = {};
+	for(auto& worker : jobs->workers) {
+		counters.submitted += reset ? worker->submitted.exchange(0) : worker->submitted.load();
+		counters.executed += reset ? worker->executed.exchange(0) : worker->executed.load();
+		counters.stolen += reset ? worker->stolen.exchange(0) : worker->stolen.load();
+		counters.sleeps += reset ? worker->sleeps.exchange(0) : worker->sleeps.load();
+		counters.busy_ns += reset ? worker->busy_ns.exchange(0) : worker->busy_ns.load();
+	}
+	return counters;
+}
+
+/**
+ * @brief Stop a job system and free it
+ * @param jobs The job system pointer
+ * @note The jobs already queued are run before the workers stop
+*/
+void JobSystem_free(JobSystem* jobs) {
+	{
+		std::lock_guard<std::mutex> lock(jobs->mutex);
+		jobs->running.store(false);
+	}
+	jobs->condition.notify_all();
+	for(auto& thread : jobs->threads) {
+		thread.join();
+	}
+	delete jobs;
+}
+
+#endif
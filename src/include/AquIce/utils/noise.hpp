@@ -0,0 +1,151 @@
+#ifndef __AQUICE_UTILS_NOISE_HPP__
+#define __AQUICE_UTILS_NOISE_HPP__
+
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief The seed offset between two octaves of fractal noise
+*/
+#define NOISE_OCTAVE_SEED 0x9E3779B9u
+
+/**
+ * @brief Hash a point of the integer lattice of 2D noise
+ * @param seed The seed of the noise
+ * @param x The x coordinate of the point
+ * @param z The z coordinate of the point
+ * @return The hash of the point
+*/
+uint32_t Noise_hash(uint32_t seed, int32_t x, int32_t z) {
+	uint32_t h = seed ^ ((uint32_t)x * 0x27D4EB2Du) ^ ((uint32_t)z * 0x165667B1u);
+	h ^= h >> 15;
+	h *= 0x2C1B3C6Du;
+	h ^= h >> 12;
+	h *= 0x297A2D39u;
+	h ^= h >> 15;
+	return h;
+}
+
+/**
+ * @brief Get the 2D value noise at a point
+ * @param seed The seed of the noise
+ * @param x The x coordinate of the point
+ * @param z The z coordinate of the point
+ * @return The noise, between 0 and 1
+*/
+float Noise_value(uint32_t seed, float x, float z) {
+	int32_t ix = (int32_t)x - (x < (float)(int32_t)x ? 1 : 0);
+	int32_t iz = (int32_t)z - (z < (float)(int32_t)z ? 1 : 0);
+	float fx = x - (float)ix;
+	float fz = z - (float)iz;
+	float u = fx * fx * (3.0f - 2.0f * fx);
+	float v = fz * fz * (3.0f - 2.0f * fz);
+	float a = (float)(int32_t)(Noise_hash(seed, ix, iz) >> 8) * (1.0f / 16777216.0f);
+	float b = (float)(int32_t)(Noise_hash(seed, ix + 1, iz) >> 8) * (1.0f / 16777216.0f);
+	float c = (float)(int32_t)(Noise_hash(seed, ix, iz + 1) >> 8) * (1.0f / 16777216.0f);
+	float d = (float)(int32_t)(Noise_hash(seed, ix + 1, iz + 1) >> 8) * (1.0f / 16777216.0f);
+	float top = a + (b - a) * u;
+	float bottom = c + (d - c) * u;
+	return top + (bottom - top) * v;
+}
+
+#ifdef __SSE2__
+/**
+ * @brief Multiply 4 pairs of 32 bit integers, keeping the low 32 bits (SSE2 has no such instruction)
+*/
+__m128i Noise_mullo(__m128i a, __m128i b) {
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/**
+ * @brief Hash 4 points of the integer lattice of 2D noise, exactly like Noise_hash
+*/
+__m128i Noise_hash4(__m128i seed, __m128i x, __m128i z) {
+	__m128i h = _mm_xor_si128(seed, _mm_xor_si128(Noise_mullo(x, _mm_set1_epi32(0x27D4EB2D)), Noise_mullo(z, _mm_set1_epi32(0x165667B1))));
+	h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+	h = Noise_mullo(h, _mm_set1_epi32(0x2C1B3C6D));
+	h = _mm_xor_si128(h, _mm_srli_epi32(h, 12));
+	h = Noise_mullo(h, _mm_set1_epi32(0x297A2D39));
+	return _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+}
+
+/**
+ * @brief Get the 2D value noise at 4 points, exactly like Noise_value
+*/
+__m128 Noise_value4(uint32_t seed, __m128 x, __m128 z) {
+	__m128i ix = _mm_cvttps_epi32(x);
+	__m128i iz = _mm_cvttps_epi32(z);
+	// Truncation rounds the negative coordinates up, the comparison masks are -1 where it did
+	ix = _mm_add_epi32(ix, _mm_castps_si128(_mm_cmplt_ps(x, _mm_cvtepi32_ps(ix))));
+	iz = _mm_add_epi32(iz, _mm_castps_si128(_mm_cmplt_ps(z, _mm_cvtepi32_ps(iz))));
+	__m128 fx = _mm_sub_ps(x, _mm_cvtepi32_ps(ix));
+	__m128 fz = _mm_sub_ps(z, _mm_cvtepi32_ps(iz));
+	__m128 three = _mm_set1_ps(3.0f);
+	__m128 two = _mm_set1_ps(2.0f);
+	__m128 u = _mm_mul_ps(_mm_mul_ps(fx, fx), _mm_sub_ps(three, _mm_mul_ps(two, fx)));
+	__m128 v = _mm_mul_ps(_mm_mul_ps(fz, fz), _mm_sub_ps(three, _mm_mul_ps(two, fz)));
+
+	__m128i s = _mm_set1_epi32((int32_t)seed);
+	__m128i one = _mm_set1_epi32(1);
+	__m128i ix1 = _mm_add_epi32(ix, one);
+	__m128i iz1 = _mm_add_epi32(iz, one);
+	__m128 scale = _mm_set1_ps(1.0f / 16777216.0f);
+	__m128 a = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(Noise_hash4(s, ix, iz), 8)), scale);
+	__m128 b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(Noise_hash4(s, ix1, iz), 8)), scale);
+	__m128 c = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(Noise_hash4(s, ix, iz1), 8)), scale);
+	__m128 d = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(Noise_hash4(s, ix1, iz1), 8)), scale);
+	__m128 top = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), u));
+	__m128 bottom = _mm_add_ps(c, _mm_mul_ps(_mm_sub_ps(d, c), u));
+	return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), v));
+}
+#endif
+
+/**
+ * @brief Get the fractal 2D value noise at many points
+ * @param seed The seed of the noise
+ * @param x The x coordinates of the points
+ * @param z The z coordinates of the points
+ * @param out The noise at the points, between 0 and 1
+ * @param count The number of points
+ * @param octaves The number of octaves, each one twice the frequency and half the amplitude of the previous one
+ * @note The points are done 4 at a time with SSE2 when available, with the exact same result as one at a time
+*/
+void Noise_fractal(uint32_t seed, const float* x, const float* z, float* out, int count, int octaves) {
+	float total = 0;
+	for(int octave = 0, amplitude = 1; octave < octaves; octave++, amplitude *= 2) {
+		total += 1.0f / amplitude;
+	}
+	int i = 0;
+#ifdef __SSE2__
+	for(; i + 4 <= count; i += 4) {
+		__m128 px = _mm_loadu_ps(x + i);
+		__m128 pz = _mm_loadu_ps(z + i);
+		__m128 sum = _mm_setzero_ps();
+		float frequency = 1, amplitude = 1;
+		for(int octave = 0; octave < octaves; octave++) {
+			__m128 f = _mm_set1_ps(frequency);
+			sum = _mm_add_ps(sum, _mm_mul_ps(Noise_value4(seed + octave * NOISE_OCTAVE_SEED, _mm_mul_ps(px, f), _mm_mul_ps(pz, f)), _mm_set1_ps(amplitude)));
+			frequency *= 2;
+			amplitude *= 0.5f;
+		}
+		_mm_storeu_ps(out + i, _mm_div_ps(sum, _mm_set1_ps(total)));
+	}
+#endif
+	for(; i < count; i++) {
+		float sum = 0;
+		float frequency = 1, amplitude = 1;
+		for(int octave = 0; octave < octaves; octave++) {
+			sum = sum + Noise_value(seed + octave * NOISE_OCTAVE_SEED, x[i] * frequency, z[i] * frequency) * amplitude;
+			frequency *= 2;
+			amplitude *= 0.5f;
+		}
+		out[i] = sum / total;
+	}
+}
+
+#endif